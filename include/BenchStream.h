@@ -0,0 +1,62 @@
+#ifndef _BENCH_STREAM_H_
+#define _BENCH_STREAM_H_
+#include <Arduino.h>
+
+// In-memory endpoint for benchmarks, replays the same input a number of times without copying
+// and only counts the response bytes
+class BenchStream : public Stream
+{
+private:
+    const char *input_;
+    const char *inptr_;
+    uint32_t repeat_;
+
+public:
+    uint32_t written;
+
+    BenchStream()
+    {
+        setInput("", 0);
+    }
+
+    void setInput(const char *text, uint32_t repeat)
+    {
+        input_ = text;
+        inptr_ = text;
+        repeat_ = *text ? repeat : 0;
+        written = 0;
+    }
+
+    virtual int available()
+    {
+        return repeat_ > 0;
+    }
+
+    virtual int read()
+    {
+        if (!repeat_)
+            return -1;
+        int c = *(inptr_++);
+        if (!*inptr_)
+        {
+            inptr_ = input_;
+            repeat_--;
+        }
+        return c;
+    }
+
+    virtual int peek()
+    {
+        return repeat_ ? *inptr_ : -1;
+    }
+
+    virtual void flush() {}
+
+    virtual size_t write(uint8_t c)
+    {
+        written++;
+        return 1;
+    }
+};
+
+#endif //_BENCH_STREAM_H_
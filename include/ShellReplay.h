@@ -0,0 +1,194 @@
+#ifndef _SHELL_REPLAY_H_
+#define _SHELL_REPLAY_H_
+#include <Shell.h>
+#include <shell/ShellRecorder.h>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+// Native only: collects a trace written by ShellRecorder
+class ShellTraceBuffer : public Print
+{
+public:
+    std::vector<uint8_t> data;
+
+    virtual size_t write(uint8_t c)
+    {
+        data.push_back(c);
+        return 1;
+    }
+    using Print::write;
+
+    bool save(const char *path)
+    {
+        FILE *f = fopen(path, "wb");
+        if (!f)
+            return false;
+        bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+        return fclose(f) == 0 && ok;
+    }
+};
+
+// Native only: feeds the inbound bytes of a ShellRecorder trace through ShellController::tick()
+// and compares the responses with the recorded ones.
+class ShellReplay : public Stream
+{
+private:
+    struct Chunk
+    {
+        uint64_t time_us; // since start of the trace
+        std::string bytes;
+    };
+    std::vector<Chunk> inbound_;
+    std::string expected_;
+    std::string actual_;
+    size_t chunk_;  // next inbound chunk
+    size_t offset_; // in inbound_[chunk_]
+    size_t released_; // chunks due until now
+
+    static bool readVarint_(const uint8_t *&p, const uint8_t *end, uint32_t &value)
+    {
+        value = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7)
+        {
+            if (p >= end)
+                return false;
+            uint8_t b = *(p++);
+            value |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+public:
+    ShellReplay()
+    {
+        chunk_ = offset_ = released_ = 0;
+    }
+
+    // parses a trace, returns false if it is not a valid trace
+    bool load(const uint8_t *data, size_t len)
+    {
+        inbound_.clear();
+        expected_.clear();
+        const uint8_t *p = data, *end = data + len;
+        if (len < 3 || p[0] != 'S' || p[1] != 'R' || p[2] != SHELL_TRACE_VERSION)
+            return false;
+        p += 3;
+        uint64_t time_us = 0;
+        while (p < end)
+        {
+            uint8_t type = *(p++);
+            uint32_t delta, n;
+            if (!readVarint_(p, end, delta) || !readVarint_(p, end, n) || n > (size_t)(end - p))
+                return false;
+            time_us += delta;
+            std::string bytes((const char *)p, n);
+            p += n;
+            if (type == SHELL_TRACE_INBOUND && n)
+                inbound_.push_back(Chunk{time_us, bytes});
+            else if (type == SHELL_TRACE_OUTBOUND || type == SHELL_TRACE_INBOUND)
+                expected_ += bytes;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    bool load(const std::vector<uint8_t> &trace)
+    {
+        return load(trace.data(), trace.size());
+    }
+
+    bool loadFile(const char *path)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return false;
+        std::vector<uint8_t> trace;
+        uint8_t buf[512];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            trace.insert(trace.end(), buf, buf + n);
+        fclose(f);
+        return load(trace);
+    }
+
+    // replays the trace, speed 1 keeps the original timing, 10 is ten times faster, 0 sends without delays.
+    // returns the wall clock duration of the replay in microseconds
+    uint64_t run(ShellController &shell, float speed = 1)
+    {
+        typedef std::chrono::steady_clock clock;
+        chunk_ = offset_ = released_ = 0;
+        actual_.clear();
+        shell.addEndpoint(*this);
+        clock::time_point start = clock::now();
+        while (chunk_ < inbound_.size())
+        {
+            uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+            while (released_ < inbound_.size() && (speed <= 0 || inbound_[released_].time_us / speed <= elapsed))
+                released_++;
+            if (chunk_ == released_)
+            {
+                // nothing to receive, sleep until the next chunk is due unless the shell has work to do
+                uint64_t due = (uint64_t)(inbound_[released_].time_us / speed);
+                if (due > elapsed + 1000)
+                    std::this_thread::sleep_for(std::chrono::microseconds(due - elapsed - 1000));
+            }
+            shell.tick();
+        }
+        shell.tick();
+        shell.removeEndpoint(*this);
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+    }
+
+    const std::string &expected() const { return expected_; }
+    const std::string &actual() const { return actual_; }
+    bool matches() const { return expected_ == actual_; }
+
+    // index of the first different response byte, or -1 if the responses match
+    long mismatch() const
+    {
+        size_t i = 0;
+        while (i < expected_.size() && i < actual_.size() && expected_[i] == actual_[i])
+            i++;
+        return (i == expected_.size() && i == actual_.size()) ? -1 : (long)i;
+    }
+
+    virtual int available()
+    {
+        return chunk_ < released_;
+    }
+
+    virtual int peek()
+    {
+        return available() ? (uint8_t)inbound_[chunk_].bytes[offset_] : -1;
+    }
+
+    virtual int read()
+    {
+        if (!available())
+            return -1;
+        int c = (uint8_t)inbound_[chunk_].bytes[offset_++];
+        if (offset_ >= inbound_[chunk_].bytes.size())
+        {
+            chunk_++;
+            offset_ = 0;
+        }
+        return c;
+    }
+
+    virtual size_t write(uint8_t c)
+    {
+        actual_ += (char)c;
+        return 1;
+    }
+    using Print::write;
+
+    virtual void flush() {}
+};
+
+#endif //_SHELL_REPLAY_H_
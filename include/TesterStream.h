@@ -45,6 +45,16 @@ public:
         }
     }
 
+    void input(const uint8_t *data, int len) // binary, may contain zeros
+    {
+        while (len--)
+        {
+            *(inhead++) = *(data++);
+            if ((int)(inhead - &inbuf[0]) >= INBUFSIZE)
+                inhead = &inbuf[0];
+        }
+    }
+
     void execute(const __FlashStringHelper *txt, bool tick = true)
     {
         input(txt);
@@ -97,6 +107,11 @@ public:
         return 1;
     }
 
+    int responseLength()
+    {
+        return responselen;
+    }
+
     char *response()
     {
         responsebuf[responselen] = 0;
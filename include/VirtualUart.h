@@ -0,0 +1,159 @@
+#ifndef _VIRTUAL_UART_H_
+#define _VIRTUAL_UART_H_
+#include <Arduino.h>
+#include <deque>
+#include <string>
+
+// Native only: serial endpoint simulated against a virtual clock, for deterministic baud rate dependent runs.
+// Bytes travel at the given baud rate in both directions. Received bytes are stored in a finite RX FIFO
+// (64 bytes like the AVR HardwareSerial buffer) and dropped when it is full. Writes block when the TX FIFO
+// is full and flush() blocks until everything is sent, like HardwareSerial; blocking advances the clock
+// and is accumulated as stall time.
+
+class VirtualClock
+{
+private:
+    uint64_t now_ns_;
+
+public:
+    VirtualClock() : now_ns_(0) {}
+    uint64_t now() const { return now_ns_; }
+    void advance(uint64_t ns) { now_ns_ += ns; }
+};
+
+class VirtualUart : public Stream
+{
+private:
+    VirtualClock &clock_;
+    uint64_t byte_ns_;
+    size_t rx_capacity_;
+    size_t tx_capacity_;
+    std::deque<uint8_t> wire_in_; // sent by host, not arrived yet
+    uint64_t wire_in_next_;       // arrival time of wire_in_.front()
+    std::deque<uint8_t> rx_fifo_;
+    std::deque<uint8_t> tx_fifo_; // written by device, front is being transmitted
+    uint64_t tx_next_;            // time when tx_fifo_.front() is completely sent
+    std::string host_rx_;
+
+    void waitTx_()
+    {
+        uint64_t now = clock_.now();
+        if (tx_next_ > now)
+        {
+            stall_ns += tx_next_ - now;
+            clock_.advance(tx_next_ - now);
+        }
+        update();
+    }
+
+public:
+    uint32_t rx_dropped;
+    uint64_t stall_ns;
+
+    VirtualUart(VirtualClock &clock, uint32_t baud, size_t rx_fifo = 64, size_t tx_fifo = 64, uint8_t frame_bits = 10)
+        : clock_(clock), rx_capacity_(rx_fifo), tx_capacity_(tx_fifo)
+    {
+        byte_ns_ = 1000000000ULL * frame_bits / baud;
+        wire_in_next_ = 0;
+        tx_next_ = 0;
+        rx_dropped = 0;
+        stall_ns = 0;
+    }
+
+    // moves everything that arrived until now, called by all other functions
+    void update()
+    {
+        uint64_t now = clock_.now();
+        while (!wire_in_.empty() && wire_in_next_ <= now)
+        {
+            if (rx_fifo_.size() < rx_capacity_)
+                rx_fifo_.push_back(wire_in_.front());
+            else
+                rx_dropped++;
+            wire_in_.pop_front();
+            wire_in_next_ += byte_ns_;
+        }
+        while (!tx_fifo_.empty() && tx_next_ <= now)
+        {
+            host_rx_ += (char)tx_fifo_.front();
+            tx_fifo_.pop_front();
+            tx_next_ += byte_ns_;
+        }
+    }
+
+    // HOST side
+    void hostWrite(const char *text)
+    {
+        update();
+        if (wire_in_.empty())
+            wire_in_next_ = clock_.now() + byte_ns_;
+        while (*text)
+            wire_in_.push_back(*(text++));
+    }
+
+    // returns and clears everything the host received so far
+    std::string hostRead()
+    {
+        update();
+        std::string s;
+        s.swap(host_rx_);
+        return s;
+    }
+
+    bool hostIdle()
+    {
+        update();
+        return wire_in_.empty() && tx_fifo_.empty();
+    }
+
+    uint64_t byteTime() const { return byte_ns_; }
+
+    // DEVICE side
+    virtual int available()
+    {
+        update();
+        return rx_fifo_.size();
+    }
+
+    virtual int read()
+    {
+        update();
+        if (rx_fifo_.empty())
+            return -1;
+        int c = rx_fifo_.front();
+        rx_fifo_.pop_front();
+        return c;
+    }
+
+    virtual int peek()
+    {
+        update();
+        return rx_fifo_.empty() ? -1 : rx_fifo_.front();
+    }
+
+    virtual int availableForWrite()
+    {
+        update();
+        return tx_capacity_ - tx_fifo_.size();
+    }
+
+    virtual size_t write(uint8_t c)
+    {
+        update();
+        while (tx_fifo_.size() >= tx_capacity_)
+            waitTx_();
+        if (tx_fifo_.empty())
+            tx_next_ = clock_.now() + byte_ns_;
+        tx_fifo_.push_back(c);
+        return 1;
+    }
+
+    virtual void flush()
+    {
+        update();
+        while (!tx_fifo_.empty())
+            waitTx_();
+    }
+};
+
+#endif //_VIRTUAL_UART_H_
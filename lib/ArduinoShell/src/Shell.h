@@ -43,4 +43,6 @@ SOFTWARE.
 #include "shell/ShellCmdHELP.h"
 #include "shell/ShellCmdFREEMEM.h"
 #include "shell/ShellCmdRESET.h"
+#include "shell/ShellCmdEVERY.h"
+#include "shell/ShellCmdSTATS.h"
 #endif //_SHELL_H
@@ -26,28 +26,10 @@ SOFTWARE.
 
 #include "shellcmd/ShellCmdPIN.h"
 #include "shellcmd/ShellCmdEEPROM.h"
-
-/*
-//todo:
-//reads atmel registers at memory addr range 0x00 to 0xff
-int8_t __run__ATMELREG(ArgumentReader &request, Print &response)
-{
-  int16_t addr;
-  if (!request.readInt(&addr))
-    return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
-  uint8_t *regptr = (uint8_t *)addr;
-  int16_t value;
-  if (request.readInt(&value))
-  {
-    *regptr = value;
-  }
-  else
-  {
-    value = *regptr;
-    response.print(value);
-  }
-  return 0;
-}
-*/
+#include "shellcmd/ShellCmdXFER.h"
+#include "shellcmd/ShellCmdCONFIG.h"
+#include "shellcmd/ShellCmdSAMPLE.h"
+#include "shellcmd/ShellCmdWATCH.h"
+#include "shellcmd/ShellCmdMEM.h"
 
 #endif //_SHELL_CMD_REPOSITORY_H
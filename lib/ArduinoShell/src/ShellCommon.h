@@ -25,6 +25,7 @@ SOFTWARE.
 #define _SHELL_COMMON_H
 
 #include <Arduino.h>
+#include "ShellConfig.h"
 #include "shell/ArgumentReader.h"
 
 // zero returned on successful execution
@@ -49,29 +50,59 @@ struct ShellCommandStruct
     PGM_P command;
     CommandHandlerFunc handler;
     PGM_P helptext;
+#if SHELL_WORKER_THREADS > 0
+    uint8_t flags;
+#endif
 };
 
-#define DECLARE_COMMAND_HANDLER(C, HELPSTR)             \
-    const char _shell_pstr_cmd_##C[] PROGMEM = #C;      \
-    const char _shell_pstr_hlp_##C[] PROGMEM = HELPSTR; \
+// handler can run on a worker thread, it must not use ShellController::context() or shared state without locking
+#define SHELL_COMMAND_FLAG_THREADSAFE 1
+
+#if SHELL_HELP_TEXT
+#define _SHELL_HELP_STRING(C, HELPSTR) \
+    const char _shell_pstr_hlp_##C[] PROGMEM = HELPSTR;
+#define _SHELL_HELP_POINTER(C) _shell_pstr_hlp_##C
+#else
+#define _SHELL_HELP_STRING(C, HELPSTR)
+#define _SHELL_HELP_POINTER(C) 0
+#endif
+
+#define DECLARE_COMMAND_HANDLER(C, HELPSTR)        \
+    const char _shell_pstr_cmd_##C[] PROGMEM = #C; \
+    _SHELL_HELP_STRING(C, HELPSTR)                 \
     extern int8_t _shell_handle_##C(ArgumentReader &, Print &)
 
 #define IMPLEMENT_COMMAND_HANDLER(C, REQ, RESP) \
     int8_t _shell_handle_##C(ArgumentReader &REQ, Print &RESP)
 
-#define COMMAND_HANDLER(C, REQ, RESP, HELPSTR)          \
-    const char _shell_pstr_cmd_##C[] PROGMEM = #C;      \
-    const char _shell_pstr_hlp_##C[] PROGMEM = HELPSTR; \
+#define COMMAND_HANDLER(C, REQ, RESP, HELPSTR)     \
+    const char _shell_pstr_cmd_##C[] PROGMEM = #C; \
+    _SHELL_HELP_STRING(C, HELPSTR)                 \
     int8_t _shell_handle_##C(ArgumentReader &REQ, Print &RESP)
 
 #define DECLARE_SHELL_COMMANDS(name) \
     const ShellCommandStruct name[] PROGMEM
 
+#if SHELL_WORKER_THREADS > 0
 #define SHELL_COMMAND(C) \
-    (ShellCommandStruct) { _shell_pstr_cmd_##C, &_shell_handle_##C, _shell_pstr_hlp_##C }
+    (ShellCommandStruct) { _shell_pstr_cmd_##C, &_shell_handle_##C, _SHELL_HELP_POINTER(C), 0 }
+
+#define SHELL_COMMAND_THREADSAFE(C) \
+    (ShellCommandStruct) { _shell_pstr_cmd_##C, &_shell_handle_##C, _SHELL_HELP_POINTER(C), SHELL_COMMAND_FLAG_THREADSAFE }
+
+// this is not to store sizeof array in memory
+#define END_SHELL_COMMANDS \
+    (ShellCommandStruct){0, 0, 0, 0},
+#else
+#define SHELL_COMMAND(C) \
+    (ShellCommandStruct) { _shell_pstr_cmd_##C, &_shell_handle_##C, _SHELL_HELP_POINTER(C) }
+
+// without worker threads all commands run in tick()
+#define SHELL_COMMAND_THREADSAFE(C) SHELL_COMMAND(C)
 
 // this is not to store sizeof array in memory
 #define END_SHELL_COMMANDS \
     (ShellCommandStruct){0, 0, 0},
+#endif
 
 #endif //_SHELL_COMMON_H
@@ -0,0 +1,167 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CONFIG_H
+#define _SHELL_CONFIG_H
+
+//********************************
+// Compile time configuration for Command Shell Library
+//
+// Define one of SHELL_PROFILE_TINY, SHELL_PROFILE_STANDARD (default) or SHELL_PROFILE_FULL as a build flag
+// to select the defaults below, any setting can still be overridden individually.
+//   TINY     : short requests, no help text, admin commands, framing switch or error strings
+//   STANDARD : all basic features, optional subsystems are disabled
+//   FULL     : STANDARD with scheduler, events, ingress queue, EEPROM write queue, transfers, tasks,
+//              statistics and tick profiler
+// tools/size_report.sh prints the flash/RAM usage of each profile, no reference sizes are recorded yet
+//********************************
+
+#if defined(SHELL_PROFILE_TINY)
+#define SHELL_PROFILE_LEVEL 0
+#elif defined(SHELL_PROFILE_FULL)
+#define SHELL_PROFILE_LEVEL 2
+#else
+#define SHELL_PROFILE_LEVEL 1
+#endif
+
+#if !defined(SHELL_MAX_REQUEST_LEN)
+#if SHELL_PROFILE_LEVEL > 0
+#define SHELL_MAX_REQUEST_LEN 80
+#else
+#define SHELL_MAX_REQUEST_LEN 40
+#endif
+#endif
+
+#if !defined(SHELL_HELP_ALIGN_MAX_COMMAND_LEN)
+#define SHELL_HELP_ALIGN_MAX_COMMAND_LEN 9
+#endif
+
+// By default backspace is defined as BS=8 character, make it NUL=0 to disable
+#if !defined(SHELL_BACKSPACE_CHAR)
+#define SHELL_BACKSPACE_CHAR 8
+#endif
+
+// Make it 0 to leave help texts out of flash, HELP lists command names only
+#if !defined(SHELL_HELP_TEXT)
+#define SHELL_HELP_TEXT (SHELL_PROFILE_LEVEL > 0)
+#endif
+
+// Make it 0 to remove support for the admin command table
+#if !defined(SHELL_ADMIN_COMMANDS)
+#define SHELL_ADMIN_COMMANDS (SHELL_PROFILE_LEVEL > 0)
+#endif
+
+// Make it 0 to remove setFraming, DefaultFraming is used for all endpoints
+#if !defined(SHELL_FRAMING_SWITCH)
+#define SHELL_FRAMING_SWITCH (SHELL_PROFILE_LEVEL > 0)
+#endif
+
+// Make it 0 to display errors as numeric codes (e.g. ERR:1) instead of messages
+#if !defined(SHELL_ERROR_STRINGS)
+#define SHELL_ERROR_STRINGS (SHELL_PROFILE_LEVEL > 0)
+#endif
+
+// Number of periodic command slots used by EVERY, make it 0 to disable the scheduler
+#if !defined(SHELL_MAX_SCHEDULES)
+#if SHELL_PROFILE_LEVEL > 1
+#define SHELL_MAX_SCHEDULES 4
+#else
+#define SHELL_MAX_SCHEDULES 0
+#endif
+#endif
+
+// Longest command line (without null termination) a schedule slot can hold
+#if !defined(SHELL_SCHEDULE_COMMAND_LEN)
+#define SHELL_SCHEDULE_COMMAND_LEN 24
+#endif
+
+// Change-only schedules (EVERY -c) buffer the response until its hash is compared, longer responses are truncated
+#if !defined(SHELL_SCHEDULE_RESPONSE_LEN)
+#define SHELL_SCHEDULE_RESPONSE_LEN 48
+#endif
+
+// Size of the ring buffer holding events queued by emitEvent (max 255), make it 0 to disable events
+#if !defined(SHELL_EVENT_BUFFER_SIZE)
+#if SHELL_PROFILE_LEVEL > 1
+#define SHELL_EVENT_BUFFER_SIZE 64
+#else
+#define SHELL_EVENT_BUFFER_SIZE 0
+#endif
+#endif
+
+// Size of the ring buffer holding command lines posted by post(), make it 0 to disable (max 255 on AVR)
+#if !defined(SHELL_INGRESS_QUEUE_LEN)
+#if SHELL_PROFILE_LEVEL > 1
+#define SHELL_INGRESS_QUEUE_LEN 64
+#else
+#define SHELL_INGRESS_QUEUE_LEN 0
+#endif
+#endif
+
+// Number of queued EEPROM writes of the EEPROM commands, make it 0 to write synchronously (max 255)
+#if !defined(SHELL_EEPROM_QUEUE_LEN)
+#if SHELL_PROFILE_LEVEL > 1
+#define SHELL_EEPROM_QUEUE_LEN 16
+#else
+#define SHELL_EEPROM_QUEUE_LEN 0
+#endif
+#endif
+
+// Make it 1 to let commands take over their endpoint for binary transfers (XFER)
+#if !defined(SHELL_TRANSFER)
+#define SHELL_TRANSFER (SHELL_PROFILE_LEVEL > 1)
+#endif
+
+// Make it 1 to run background tasks (SAMPLE, WATCH) from tick() and let them send events directly
+#if !defined(SHELL_TASKS)
+#define SHELL_TASKS (SHELL_PROFILE_LEVEL > 1)
+#endif
+
+// Native only: number of worker threads running commands declared with SHELL_COMMAND_THREADSAFE, 0 runs all in tick()
+#if !defined(SHELL_WORKER_THREADS)
+#define SHELL_WORKER_THREADS 0
+#endif
+#if SHELL_WORKER_THREADS > 0 && !(defined(__unix__) || defined(__APPLE__))
+#error "SHELL_WORKER_THREADS is supported only on native builds"
+#endif
+
+// Number of commands execution statistics are recorded for, make it 0 to disable statistics
+#if !defined(SHELL_MAX_COMMAND_STATS)
+#if SHELL_PROFILE_LEVEL > 1
+#define SHELL_MAX_COMMAND_STATS 8
+#else
+#define SHELL_MAX_COMMAND_STATS 0
+#endif
+#endif
+
+// Make it 1 to count traffic and receive errors for each endpoint
+#if !defined(SHELL_ENDPOINT_STATS)
+#define SHELL_ENDPOINT_STATS (SHELL_PROFILE_LEVEL > 1)
+#endif
+
+// Make it 1 to record a latency histogram of tick() calls
+#if !defined(SHELL_TICK_PROFILER)
+#define SHELL_TICK_PROFILER (SHELL_PROFILE_LEVEL > 1)
+#endif
+
+#endif //_SHELL_CONFIG_H
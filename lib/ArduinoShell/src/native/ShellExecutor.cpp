@@ -0,0 +1,152 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellExecutor.h"
+#if SHELL_WORKER_THREADS > 0
+#include <fcntl.h>
+#include <unistd.h>
+
+// collects the response of a job
+class ShellJobOutput : public Print
+{
+private:
+  std::string *text_;
+
+public:
+  ShellJobOutput(std::string &text) : text_(&text) {}
+  virtual size_t write(uint8_t c)
+  {
+    *text_ += (char)c;
+    return 1;
+  }
+};
+
+ShellExecutor::ShellExecutor(uint8_t threads)
+{
+  stopping_ = false;
+  if (pipe(notify_) == 0)
+  {
+    fcntl(notify_[0], F_SETFL, fcntl(notify_[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(notify_[1], F_SETFL, fcntl(notify_[1], F_GETFL, 0) | O_NONBLOCK);
+  }
+  else
+    notify_[0] = notify_[1] = -1;
+  for (uint8_t i = 0; i < threads; i++)
+    threads_.push_back(std::thread(&ShellExecutor::work_, this));
+}
+
+ShellExecutor::~ShellExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_all();
+  for (size_t i = 0; i < threads_.size(); i++)
+    threads_[i].join();
+  for (size_t i = 0; i < pending_.size(); i++)
+    delete pending_[i];
+  for (size_t i = 0; i < completed_.size(); i++)
+    delete completed_[i];
+  if (notify_[0] >= 0)
+  {
+    close(notify_[0]);
+    close(notify_[1]);
+  }
+}
+
+void ShellExecutor::submit(ShellJob *job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(job);
+    jobs_.push_back(job);
+  }
+  wakeup_.notify_one();
+}
+
+ShellJob *ShellExecutor::completed()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (completed_.empty())
+  {
+    char buf[32];
+    while (notify_[0] >= 0 && read(notify_[0], buf, sizeof(buf)) > 0)
+      ; // drained while no completion is pending, so the descriptor is readable only when there is one
+    return 0;
+  }
+  ShellJob *job = completed_.front();
+  completed_.pop_front();
+  for (size_t i = 0; i < jobs_.size(); i++)
+    if (jobs_[i] == job)
+    {
+      jobs_.erase(jobs_.begin() + i);
+      break;
+    }
+  return job;
+}
+
+void ShellExecutor::cancel(ShellEndpoint *session)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < jobs_.size(); i++)
+    if (jobs_[i]->session == session)
+      jobs_[i]->session = 0; // workers do not read it
+}
+
+void ShellExecutor::work_()
+{
+  ArgumentReader request; // each worker parses its own copy of the request
+  for (;;)
+  {
+    ShellJob *job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (pending_.empty() && !stopping_)
+        wakeup_.wait(lock);
+      if (stopping_)
+        return;
+      job = pending_.front();
+      pending_.pop_front();
+    }
+    ShellJobOutput out(job->response);
+    char *cmdstart;
+    request.begin(job->line);
+    request.readString(&cmdstart, true);
+    uint32_t start = micros();
+    job->result = job->handler(request, out);
+    job->duration_us = micros() - start;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      completed_.push_back(job);
+    }
+    if (notify_[1] >= 0)
+    {
+      char c = 0;
+      ssize_t n = write(notify_[1], &c, 1); // fails only if the pipe is full, it is readable then anyway
+      (void)n;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,82 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_EXECUTOR_H_
+#define _SHELL_EXECUTOR_H_
+
+#include <ShellCommon.h>
+
+// Native worker threads for commands declared with SHELL_COMMAND_THREADSAFE.
+// The controller looks up commands and sends responses on the thread calling tick(), workers parse the arguments
+// from a copy of the request line and run the handlers.
+// A session (endpoint) has at most one job in flight and is not read meanwhile, so its responses keep the request order.
+#if SHELL_WORKER_THREADS > 0
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ShellEndpoint;
+
+struct ShellJob
+{
+    ShellEndpoint *session;
+    Stream *stream;
+    ShellCommandStruct *command;
+    CommandHandlerFunc handler;
+    byte line[SHELL_MAX_REQUEST_LEN + 1];
+    std::string response;
+    int8_t result;
+    uint32_t duration_us;
+};
+
+class ShellExecutor
+{
+private:
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<ShellJob *> pending_;
+    std::deque<ShellJob *> completed_;
+    std::vector<ShellJob *> jobs_; // submitted and not yet taken by completed()
+    bool stopping_;
+    int notify_[2]; // pipe, a byte is written for every completed job
+    void work_();
+
+public:
+    ShellExecutor(uint8_t threads);
+    ~ShellExecutor(); // waits for running jobs
+    void submit(ShellJob *job);
+    // next completed job or null, the caller deletes it
+    ShellJob *completed();
+    // clears the session of the jobs in flight for it, their responses are discarded instead of reaching a reused endpoint
+    void cancel(ShellEndpoint *session);
+    // becomes readable when a job completes, event loops can poll it to call tick() without delay
+    int getNotifyFd() { return notify_[0]; }
+};
+
+#endif
+#endif //_SHELL_EXECUTOR_H_
@@ -0,0 +1,354 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "ShellHost.h"
+#include "ShellExecutor.h"
+
+static bool setNonBlocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+ShellFdStream::ShellFdStream(int fd, char delimiter)
+{
+  fd_ = fd;
+  closed_ = false;
+  delimiter_ = delimiter;
+  in_head_ = in_ready_ = in_len_ = 0;
+  out_len_ = 0;
+}
+
+ShellFdStream::~ShellFdStream()
+{
+  close(fd_);
+}
+
+bool ShellFdStream::receive(bool raw)
+{
+  if (closed_)
+    return false;
+  if (in_head_ > 0)
+  { // compact, keeps the unread part at the beginning
+    memmove(in_, in_ + in_head_, in_len_ - in_head_);
+    in_ready_ -= in_head_;
+    in_len_ -= in_head_;
+    in_head_ = 0;
+  }
+  if (in_len_ >= SHELL_HOST_BUFFER_LEN)
+    return true; // wait until the shell reads
+  ssize_t n = ::read(fd_, in_ + in_len_, SHELL_HOST_BUFFER_LEN - in_len_);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+  {
+    closed_ = true;
+    return false;
+  }
+  if (n > 0)
+    in_len_ += n;
+  if (!delimiter_ || raw || in_len_ >= SHELL_HOST_BUFFER_LEN)
+    in_ready_ = in_len_; // a full buffer is released, the shell reports the line as too long
+  else
+    for (uint16_t i = in_len_; i > in_ready_; i--)
+      if (in_[i - 1] == delimiter_)
+      {
+        in_ready_ = i;
+        break;
+      }
+  return true;
+}
+
+int ShellFdStream::read()
+{
+  if (!available())
+    return -1;
+  return in_[in_head_++];
+}
+
+size_t ShellFdStream::write(uint8_t c)
+{
+  if (closed_)
+    return 0;
+  if (out_len_ >= SHELL_HOST_BUFFER_LEN)
+    flush();
+  out_[out_len_++] = c;
+  return 1;
+}
+
+void ShellFdStream::flush()
+{
+  uint16_t sent = 0;
+  while (sent < out_len_ && !closed_)
+  {
+    ssize_t n = ::write(fd_, out_ + sent, out_len_ - sent);
+    if (n > 0)
+      sent += n;
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      struct pollfd p = {fd_, POLLOUT, 0};
+      if (::poll(&p, 1, SHELL_HOST_WRITE_TIMEOUT_MS) <= 0)
+        closed_ = true; // client does not read
+    }
+    else if (n < 0 && errno != EINTR)
+      closed_ = true;
+  }
+  out_len_ = 0;
+}
+
+ShellHost::ShellHost(ShellController &shell)
+{
+  shell_ = &shell;
+  listener_count_ = 0;
+  pty_slave_ = -1;
+  pty_name_[0] = 0;
+  unix_path_[0] = 0;
+  signal(SIGPIPE, SIG_IGN); // closed clients are detected by write() errors
+}
+
+ShellHost::~ShellHost()
+{
+  for (size_t i = 0; i < clients_.size(); i++)
+  {
+    shell_->removeEndpoint(clients_[i]->endpoint);
+    delete clients_[i];
+  }
+  for (uint8_t i = 0; i < listener_count_; i++)
+    close(listeners_[i]);
+  if (pty_slave_ >= 0)
+    close(pty_slave_);
+  if (unix_path_[0])
+    unlink(unix_path_);
+}
+
+bool ShellHost::addListener_(int fd)
+{
+  if (listener_count_ >= SHELL_HOST_MAX_LISTENERS || !setNonBlocking(fd) || listen(fd, 16) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  listeners_[listener_count_++] = fd;
+  return true;
+}
+
+bool ShellHost::addClient_(int fd)
+{
+  if (!setNonBlocking(fd))
+  {
+    close(fd);
+    return false;
+  }
+  ShellFdStream *client = new ShellFdStream(fd);
+  clients_.push_back(client);
+  shell_->addEndpoint(client->endpoint, *client, true);
+  return true;
+}
+
+bool ShellHost::listenTcp(uint16_t port, const char *address)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address, &addr.sin_addr) != 1 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  return addListener_(fd);
+}
+
+bool ShellHost::listenUnix(const char *path)
+{
+  struct sockaddr_un addr;
+  if (unix_path_[0] || strlen(path) >= sizeof(addr.sun_path))
+    return false; // single unix socket, path is removed by destructor
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  strcpy(unix_path_, path);
+  return addListener_(fd);
+}
+
+const char *ShellHost::openPty()
+{
+  if (pty_slave_ >= 0)
+    return pty_name_;
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0)
+    return 0;
+  const char *name = 0;
+  if (grantpt(master) == 0 && unlockpt(master) == 0)
+    name = ptsname(master);
+  if (name)
+    pty_slave_ = open(name, O_RDWR | O_NOCTTY);
+  if (pty_slave_ < 0)
+  {
+    close(master);
+    return 0;
+  }
+  struct termios tio;
+  tcgetattr(pty_slave_, &tio);
+  cfmakeraw(&tio); // no echo and no line translation, behaves like a serial port
+  tcsetattr(pty_slave_, TCSANOW, &tio);
+  strncpy(pty_name_, name, sizeof(pty_name_) - 1);
+  pty_name_[sizeof(pty_name_) - 1] = 0;
+  if (!addClient_(master))
+  {
+    close(pty_slave_);
+    pty_slave_ = -1;
+    return 0;
+  }
+  return pty_name_;
+}
+
+void ShellHost::accept_(int listener)
+{
+  for (;;)
+  {
+    int fd = accept(listener, 0, 0);
+    if (fd < 0)
+      return;
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // fails harmlessly on unix sockets
+    addClient_(fd);
+  }
+}
+
+void ShellHost::removeClosed_()
+{
+  size_t j = 0;
+  for (size_t i = 0; i < clients_.size(); i++)
+  {
+    ShellFdStream *client = clients_[i];
+    if (client->closed())
+    {
+      shell_->removeEndpoint(client->endpoint);
+      delete client;
+    }
+    else
+      clients_[j++] = client;
+  }
+  clients_.resize(j);
+}
+
+// has a line the shell can execute now
+static bool executable(ShellFdStream *client)
+{
+#if SHELL_WORKER_THREADS > 0
+  if (client->endpoint.busy)
+    return false;
+#endif
+  return client->endpoint.ready;
+}
+
+bool ShellHost::poll(int timeout_ms)
+{
+  fds_.resize(listener_count_ + clients_.size() + 1);
+  size_t n = 0;
+  for (uint8_t i = 0; i < listener_count_; i++, n++)
+  {
+    fds_[n].fd = listeners_[i];
+    fds_[n].events = POLLIN;
+    fds_[n].revents = 0;
+  }
+  for (size_t i = 0; i < clients_.size(); i++, n++)
+  {
+    fds_[n].fd = clients_[i]->fd();
+    fds_[n].events = POLLIN;
+    fds_[n].revents = 0;
+  }
+#if SHELL_WORKER_THREADS > 0
+  if (shell_->getExecutor())
+  { // wakes up when a worker completes a command
+    fds_[n].fd = shell_->getExecutor()->getNotifyFd();
+    fds_[n].events = POLLIN;
+    fds_[n].revents = 0;
+    n++;
+  }
+#endif
+  size_t polled_clients = clients_.size(); // clients accepted below are polled next time
+  int ready = ::poll(fds_.data(), n, timeout_ms);
+  if (ready < 0 && errno != EINTR)
+    return false;
+  if (ready > 0)
+  {
+    for (size_t i = 0; i < polled_clients; i++)
+    {
+      ShellFdStream *client = clients_[i];
+#if SHELL_TRANSFER
+      bool raw = shell_->getTransferEndpoint() == client; // binary transfer
+#else
+      bool raw = false;
+#endif
+      if (fds_[listener_count_ + i].revents && client->receive(raw) && client->available())
+        shell_->markReady(client->endpoint);
+    }
+    for (uint8_t i = 0; i < listener_count_; i++)
+      if (fds_[i].revents & POLLIN)
+        accept_(listeners_[i]);
+  }
+  // at least one tick per poll, so schedules, tasks, events and completed commands are not delayed by busy clients
+  // the shell visits only the ready clients, each tick executes at most one line
+  bool lines;
+  do
+  {
+    shell_->tick();
+    lines = false;
+    for (size_t i = 0; i < polled_clients && !lines; i++)
+      lines = executable(clients_[i]);
+  } while (lines);
+  for (size_t i = 0; i < clients_.size(); i++)
+    clients_[i]->flush(); // events are not flushed by the shell
+  removeClosed_();
+  return true;
+}
+
+#endif
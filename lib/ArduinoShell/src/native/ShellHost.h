@@ -0,0 +1,118 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_HOST_H_
+#define _SHELL_HOST_H_
+
+// Native host transports, the shell serves local clients over TCP, Unix domain sockets and a PTY.
+// Each accepted client is a separate endpoint which notifies the shell when a line is received.
+// Lines end with CR like on serial ports, e.g. connect with: nc -C 127.0.0.1 <port>
+#if defined(__unix__) || defined(__APPLE__)
+#define SHELL_NATIVE_HOST 1
+
+#include <Arduino.h>
+#include <poll.h>
+#include <vector>
+#include "../shell/ShellController.h"
+
+#if !defined(SHELL_HOST_BUFFER_LEN)
+#define SHELL_HOST_BUFFER_LEN 256 // per client, for each direction
+#endif
+
+#if !defined(SHELL_HOST_MAX_LISTENERS)
+#define SHELL_HOST_MAX_LISTENERS 4
+#endif
+
+#if !defined(SHELL_HOST_WRITE_TIMEOUT_MS)
+#define SHELL_HOST_WRITE_TIMEOUT_MS 1000 // clients not reading for longer are closed
+#endif
+
+// Stream over a non-blocking file descriptor. Input is made available a line at a time (up to delimiter),
+// so partial lines of different clients are never mixed in the shared request buffer.
+class ShellFdStream : public Stream
+{
+private:
+    int fd_;
+    bool closed_;
+    char delimiter_; // 0 makes every received byte available immediately
+    uint8_t in_[SHELL_HOST_BUFFER_LEN];
+    uint16_t in_head_;
+    uint16_t in_ready_; // bytes before this index are available
+    uint16_t in_len_;
+    uint8_t out_[SHELL_HOST_BUFFER_LEN];
+    uint16_t out_len_;
+
+public:
+    ShellEndpoint endpoint;
+
+    ShellFdStream(int fd, char delimiter = '\r');
+    virtual ~ShellFdStream(); // closes the descriptor
+    int fd() { return fd_; }
+    bool closed() { return closed_; }
+    // reads what the descriptor has, call when it is readable. returns false when it is closed
+    // raw makes the bytes available without waiting for the delimiter, used by transfers
+    bool receive(bool raw = false);
+
+    virtual int available() { return in_ready_ - in_head_; }
+    virtual int peek() { return available() ? in_[in_head_] : -1; }
+    virtual int read();
+    virtual size_t write(uint8_t c);
+    virtual int availableForWrite() { return SHELL_HOST_BUFFER_LEN - out_len_; }
+    virtual void flush();
+    using Print::write;
+};
+
+// poll() driven event loop, adds accepted clients to the shell as endpoints and removes them when closed
+class ShellHost
+{
+private:
+    ShellController *shell_;
+    int listeners_[SHELL_HOST_MAX_LISTENERS];
+    uint8_t listener_count_;
+    std::vector<ShellFdStream *> clients_;
+    std::vector<struct pollfd> fds_;
+    int pty_slave_; // kept open so the master does not hang up when no terminal is attached
+    char pty_name_[64];
+    char unix_path_[108];
+
+    bool addListener_(int fd);
+    bool addClient_(int fd);
+    void accept_(int listener);
+    void removeClosed_();
+
+public:
+    ShellHost(ShellController &shell);
+    ~ShellHost();
+    bool listenTcp(uint16_t port, const char *address = "127.0.0.1");
+    bool listenUnix(const char *path);
+    // opens a raw mode pseudo terminal served as an endpoint, returns the device to connect to or null
+    const char *openPty();
+    // waits up to timeout_ms for input, then ticks the shell until all received lines are executed.
+    // the shell also ticks when the timeout expires, so schedules and events still run.
+    // returns false on a poll() error
+    bool poll(int timeout_ms);
+    size_t getClientCount() { return clients_.size(); }
+};
+
+#endif
+#endif //_SHELL_HOST_H_
@@ -0,0 +1,67 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdEVERY.h"
+#include <ShellCore.h>
+
+IMPLEMENT_COMMAND_HANDLER(EVERY, request, response)
+{
+#if SHELL_MAX_SCHEDULES > 0
+    ShellController *ctx = ShellController::context();
+    if (!ctx)
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    char *arg;
+    if (!request.readString(&arg))
+    {
+        ctx->printSchedules(response);
+        return 0;
+    }
+    if (strcasecmp_P(arg, PSTR("-D")) == 0)
+    {
+        int16_t slot = -1;
+        if (request.readInt(&slot, 0, SHELL_MAX_SCHEDULES - 1) < 0)
+            return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+        ctx->unschedule(slot);
+        return 0;
+    }
+    long interval;
+    if (!ArgumentReader::atol(arg, &interval) || interval <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    bool change_only = false;
+    char *cmd = request.peek();
+    if (strncasecmp_P(cmd, PSTR("-C "), 3) == 0)
+    {
+        change_only = true;
+        request.readString(&cmd);
+    }
+    if (!request.readToEnd(&cmd))
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    int8_t slot = ctx->schedule(interval, cmd, ctx->getRequestingEndpoint(), change_only);
+    if (slot < 0)
+        return -slot;
+    response.print(slot);
+    return 0;
+#else
+    return SHELL_RESPONSE_ERR_ILLEGAL_OPERATION;
+#endif
+}
@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdSTATS.h"
+#include <ShellCore.h>
+
+#define F_P(x) (reinterpret_cast<const __FlashStringHelper *>(x))
+
+#if SHELL_MAX_COMMAND_STATS > 0
+static void printCommandStats(ShellController *ctx, Print &response, const char *cmd)
+{
+    bool first = true;
+    const ShellCommandStats *st;
+    for (uint8_t i = 0; (st = ctx->getCommandStats(i)) != 0; i++)
+    {
+        PGM_P cmdp = (PGM_P)pgm_read_ptr_near(&(st->command->command));
+        if (cmd && strcasecmp_P(cmd, cmdp) != 0)
+            continue;
+        uint32_t errors = 0;
+        for (uint8_t e = 0; e <= SHELL_RESPONSE_ERROR_COUNT; e++)
+            errors += st->errors[e];
+        if (!first)
+            response.println();
+        first = false;
+        response.print(F_P(cmdp));
+        int len = SHELL_HELP_ALIGN_MAX_COMMAND_LEN - strlen_P(cmdp);
+        while (len-- > 0)
+            response.write(' ');
+        response.write(' ');
+        response.print(st->calls);
+        response.write(' ');
+        response.print(errors);
+        response.write(' ');
+        response.print(st->total_us / st->calls);
+        response.write(' ');
+        response.print(st->max_us);
+        if (cmd) // SPECIFIC command also lists errors by code
+        {
+            for (uint8_t e = 0; e <= SHELL_RESPONSE_ERROR_COUNT; e++)
+            {
+                if (!st->errors[e])
+                    continue;
+                response.println();
+                // custom errors are displayed without code, last index is the unknown error
+                ctx->printError(response, e < SHELL_RESPONSE_ERROR_COUNT ? e : SHELL_RESPONSE_ERR_UNKNOWN_ERROR);
+                response.write(' ');
+                response.print(st->errors[e]);
+            }
+        }
+    }
+}
+#endif
+
+#if SHELL_ENDPOINT_STATS
+static void printEndpointStats(ShellController *ctx, Print &response)
+{
+    const ShellEndpointStats *st;
+    const ShellEndpointStats *requesting = 0;
+    if (ctx->getRequestingEndpoint())
+        requesting = ctx->getEndpointStats(*ctx->getRequestingEndpoint());
+    for (uint8_t i = 0; (st = ctx->getEndpointStats(i)) != 0; i++)
+    {
+        if (i)
+            response.println();
+        response.print(i);
+        if (st == requesting) // marks the endpoint this command was received from
+            response.write('*');
+        response.write(' ');
+        response.print(st->bytes_in);
+        response.write(' ');
+        response.print(st->bytes_out);
+        response.write(' ');
+        response.print(st->frames);
+        response.write(' ');
+        response.print(st->bad_frames);
+        response.write(' ');
+        response.print(st->overlong_lines);
+        response.write(' ');
+        response.print(st->empty_lines);
+        response.write(' ');
+        response.print(st->max_line_len);
+    }
+}
+#endif
+
+#if SHELL_TICK_PROFILER
+static void printTickProfile(Print &response, const ShellTickProfile *profile)
+{
+    for (uint8_t phase = 0; phase < SHELL_TICK_PHASE_COUNT; phase++)
+    {
+        ArgumentReader::printEnum(response, phase, PSTR("IDLE|RECEIVE|EXECUTE"));
+        response.write(' ');
+        response.print(profile->max_us[phase]);
+        // histogram is printed up to the last non-empty bucket
+        int8_t last = SHELL_TICK_PROFILE_BUCKETS - 1;
+        while (last > 0 && !profile->histogram[phase][last])
+            last--;
+        for (int8_t bucket = 0; bucket <= last; bucket++)
+        {
+            response.write(bucket ? ',' : ' ');
+            response.print(profile->histogram[phase][bucket]);
+        }
+        response.println();
+    }
+    response.print(F("WORST "));
+    if (profile->max_command)
+        response.print(F_P(pgm_read_ptr_near(&(profile->max_command->command))));
+}
+#endif
+
+IMPLEMENT_COMMAND_HANDLER(STATS, request, response)
+{
+    ShellController *ctx = ShellController::context();
+    if (!ctx)
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    char *cmd;
+    if (!request.readString(&cmd))
+        cmd = 0;
+    else if (strcasecmp_P(cmd, PSTR("-R")) == 0)
+    {
+#if SHELL_MAX_COMMAND_STATS > 0
+        ctx->resetCommandStats();
+#endif
+#if SHELL_ENDPOINT_STATS
+        ctx->resetEndpointStats();
+#endif
+#if SHELL_TICK_PROFILER
+        ctx->resetTickProfile();
+#endif
+        return 0;
+    }
+    else if (strcasecmp_P(cmd, PSTR("-E")) == 0)
+    {
+#if SHELL_ENDPOINT_STATS
+        printEndpointStats(ctx, response);
+        return 0;
+#else
+        return SHELL_RESPONSE_ERR_ILLEGAL_OPERATION;
+#endif
+    }
+    else if (strcasecmp_P(cmd, PSTR("-T")) == 0)
+    {
+#if SHELL_TICK_PROFILER
+        printTickProfile(response, ctx->getTickProfile());
+        return 0;
+#else
+        return SHELL_RESPONSE_ERR_ILLEGAL_OPERATION;
+#endif
+    }
+#if SHELL_MAX_COMMAND_STATS > 0
+    printCommandStats(ctx, response, cmd);
+    return 0;
+#else
+    return SHELL_RESPONSE_ERR_ILLEGAL_OPERATION;
+#endif
+}
@@ -0,0 +1,33 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CMD_STATS_H_
+#define _SHELL_CMD_STATS_H_
+#include <ShellCommon.h>
+
+// Command columns are calls, errors, average and maximum execution time in us (needs SHELL_MAX_COMMAND_STATS > 0)
+// -e columns are bytes in, bytes out, frames, bad frames, overlong, empty and longest line (needs SHELL_ENDPOINT_STATS)
+// -t displays maximum us and log2 histogram of tick() durations per phase and the slowest command (needs SHELL_TICK_PROFILER)
+DECLARE_COMMAND_HANDLER(STATS, "Displays runtime statistics. [-r|-e|-t|<cmd>]");
+
+#endif //_SHELL_CMD_STATS_H_
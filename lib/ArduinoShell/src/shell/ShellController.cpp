@@ -22,19 +22,18 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "ShellController.h"
+#if SHELL_WORKER_THREADS > 0
+#include "../native/ShellExecutor.h"
+#endif
+#if SHELL_EEPROM_QUEUE_LEN > 0
+#include "../shellcmd/ShellEepromQueue.h"
+#endif
 
 #define F_P(x) (reinterpret_cast<const __FlashStringHelper *>(x))
 
-// These error codes should be sequential in DESCENDING order, start should be 0x7f
-const int8_t SHELL_RESPONSE_ERR_UNKNOWN_ERROR = 127;
-const int8_t SHELL_RESPONSE_ERR_BAD_COMMAND = 126;
-const int8_t SHELL_RESPONSE_ERR_COMMAND_TOO_LONG = 125;
-const int8_t SHELL_RESPONSE_ERR_BAD_FRAME = 124;
-// remember to increment count if new system commands are defined
-#define SHELL_RESPONSE_SYSTEM_ERROR_COUNT 4
-
+const char PSTR_SHELL_RESPONSE_ERR_BAD_COMMAND[] PROGMEM = "Unknown command"; // also used by help
+#if SHELL_ERROR_STRINGS
 const char PSTR_SHELL_RESPONSE_ERR_UNKNOWN_ERROR[] PROGMEM = "Unknown error";
-const char PSTR_SHELL_RESPONSE_ERR_BAD_COMMAND[] PROGMEM = "Unknown command";
 const char PSTR_SHELL_RESPONSE_ERR_COMMAND_TOO_LONG[] PROGMEM = "Command too long";
 const char PSTR_SHELL_RESPONSE_ERR_BAD_FRAME[] PROGMEM = "Bad frame";
 
@@ -46,6 +45,7 @@ const char *const system_error_strings[SHELL_RESPONSE_SYSTEM_ERROR_COUNT] PROGME
         PSTR_SHELL_RESPONSE_ERR_COMMAND_TOO_LONG,
         PSTR_SHELL_RESPONSE_ERR_BAD_FRAME,
 };
+#endif
 
 //*************** Framing **************
 
@@ -53,6 +53,7 @@ const char *const system_error_strings[SHELL_RESPONSE_SYSTEM_ERROR_COUNT] PROGME
 const uint8_t PRINTMODE_IGNORE = 0;     // Ignores writes
 const uint8_t PRINTMODE_REQUESTING = 1; // Forwarded to the request buffer
 const uint8_t PRINTMODE_RESPONDING = 2; // Forwarded to requesting stream (CLI)
+const uint8_t PRINTMODE_HASHING = 3;    // Only updates the response hash (change-only schedules)
 // Note: doing this using inner classes wasted 32 byte RAM
 
 const char NUL = 0;
@@ -90,6 +91,10 @@ public:
     }
     return 0;
   }
+  virtual void beginEvent(Print *out)
+  {
+    out->print(F("EVT:"));
+  }
 };
 
 //******************* ShellController Implementation ****************************
@@ -104,13 +109,54 @@ ShellController *ShellController::context()
 ShellController::ShellController()
 {
   user_command_start_P_ = 0;
+#if SHELL_ADMIN_COMMANDS
   admin_command_start_P_ = 0;
+#endif
   request_ = new ArgumentReader();
   default_cmd_framing_ = new DefaultFraming();
   framing_layer_ = default_cmd_framing_;
+#if SHELL_FRAMING_SWITCH
   pending_framing_ = 0;
+#endif
   print_mode_ = PRINTMODE_IGNORE;
-  memset(endpoints_, 0, sizeof(endpoints_));
+  endpoints_head_ = endpoints_tail_ = 0;
+  ready_head_ = ready_tail_ = 0;
+  polled_count_ = 0;
+#if SHELL_MAX_SCHEDULES > 0
+  memset(schedules_, 0, sizeof(schedules_));
+  next_schedule_ = 0;
+#endif
+#if SHELL_MAX_COMMAND_STATS > 0
+  resetCommandStats();
+#endif
+#if SHELL_ENDPOINT_STATS
+  resetEndpointStats();
+#endif
+  requesting_endpoint_ = 0;
+  requesting_node_ = 0;
+  response_framing_ = framing_layer_;
+#if SHELL_TICK_PROFILER
+  resetTickProfile();
+#endif
+#if SHELL_WORKER_THREADS > 0
+  executor_ = 0;
+#endif
+#if SHELL_TRANSFER
+  transfer_ = 0;
+  transfer_node_ = 0;
+#endif
+#if SHELL_TASKS
+  tasks_ = 0;
+#endif
+#if SHELL_INGRESS_QUEUE_LEN > 0
+  ingress_head_ = 0;
+  ingress_tail_ = 0;
+  ingress_out_ = 0;
+#endif
+#if SHELL_EVENT_BUFFER_SIZE > 0
+  events_head_ = 0;
+  events_tail_ = 0;
+#endif
 }
 
 void ShellController::begin(const ShellCommandStruct user_commands[], const __FlashStringHelper *prompt)
@@ -118,6 +164,10 @@ void ShellController::begin(const ShellCommandStruct user_commands[], const __Fl
   ((DefaultFraming *)default_cmd_framing_)->begin(prompt);
   request_buf_ptr_ = &request_buf_[0];
   setUserCommands(user_commands);
+#if SHELL_WORKER_THREADS > 0
+  if (!executor_)
+    executor_ = new ShellExecutor(SHELL_WORKER_THREADS);
+#endif
 }
 
 void ShellController::setUserCommands(const ShellCommandStruct user_commands[])
@@ -125,45 +175,147 @@ void ShellController::setUserCommands(const ShellCommandStruct user_commands[])
   user_command_start_P_ = (PGM_P)user_commands;
 }
 
+#if SHELL_ADMIN_COMMANDS
 void ShellController::setAdminCommands(const ShellCommandStruct admin_commands[])
 {
   admin_command_start_P_ = (PGM_P)admin_commands;
 }
+#endif
 
+#if SHELL_FRAMING_SWITCH
 void ShellController::setFraming(ShellFraming *framing)
 {
   this->pending_framing_ = framing ? framing : default_cmd_framing_;
 }
+#endif
+
+void ShellController::addEndpoint(ShellEndpoint &endpoint, Stream &stream, bool notify, ShellFraming *framing)
+{
+  if (endpoint.stream || findEndpoint_(&stream)) // node in use or stream already added, relinking would corrupt the list
+    return;
+  endpoint.stream = &stream;
+  endpoint.framing = framing;
+  endpoint.prev = endpoints_tail_;
+  endpoint.next = 0;
+  endpoint.ready_prev = endpoint.ready_next = 0;
+  endpoint.notify = notify;
+  endpoint.ready = false;
+  endpoint.owned = false;
+#if SHELL_WORKER_THREADS > 0
+  endpoint.busy = false;
+#endif
+#if SHELL_ENDPOINT_STATS
+  memset(&endpoint.stats, 0, sizeof(ShellEndpointStats));
+#endif
+  if (endpoints_tail_)
+    endpoints_tail_->next = &endpoint;
+  else
+    endpoints_head_ = &endpoint;
+  endpoints_tail_ = &endpoint;
+  if (!notify)
+    polled_count_++;
+}
 
-void ShellController::addEndpoint(Stream &stream)
+void ShellController::addEndpoint(Stream &stream, ShellFraming *framing)
 {
-  for (int8_t i = 0; i < SHELL_MAX_ENDPOINTS; i++)
+  if (findEndpoint_(&stream)) // prevent duplicates
+    return;
+  ShellEndpoint *endpoint = new ShellEndpoint();
+  addEndpoint(*endpoint, stream, false, framing);
+  endpoint->owned = true;
+}
+
+void ShellController::removeEndpoint(ShellEndpoint &endpoint)
+{
+  Stream *stream = endpoint.stream;
+  if (!stream)
+    return;
+  unmarkReady_(&endpoint);
+  if (requesting_node_ == &endpoint)
+    requesting_node_ = 0;
+#if SHELL_WORKER_THREADS > 0
+  if (executor_ && endpoint.busy)
+    executor_->cancel(&endpoint); // the node may be reused by a new endpoint before the job completes
+  endpoint.busy = false;
+#endif
+#if SHELL_TRANSFER
+  if (transfer_node_ == &endpoint)
   {
-    Stream *s = endpoints_[i];
-    if (s == &stream) // prevent duplicates
-      break;
-    if (!s) // find first empty cell and insert
-    {
-      endpoints_[i] = &stream;
-      break;
-    }
+    transfer_->cancel();
+    transfer_ = 0;
+    transfer_node_ = 0;
   }
+#endif
+  if (endpoint.prev)
+    endpoint.prev->next = endpoint.next;
+  else
+    endpoints_head_ = endpoint.next;
+  if (endpoint.next)
+    endpoint.next->prev = endpoint.prev;
+  else
+    endpoints_tail_ = endpoint.prev;
+  if (!endpoint.notify)
+    polled_count_--;
+  endpoint.stream = 0;
+  endpoint.prev = endpoint.next = 0;
+#if SHELL_MAX_SCHEDULES > 0
+  for (int8_t i = 0; i < SHELL_MAX_SCHEDULES; i++)
+    if (schedules_[i].endpoint == stream)
+      schedules_[i].endpoint = 0;
+#endif
 }
 
 void ShellController::removeEndpoint(Stream &stream)
 {
-  for (int8_t i = 0; i < SHELL_MAX_ENDPOINTS; i++)
-  {
-    Stream *s = endpoints_[i];
-    if (s == &stream)
-    {
-      // found at index i, shift all to left and clear final cell
-      for (int8_t j = i; j < SHELL_MAX_ENDPOINTS - 1; j++)
-        endpoints_[j] = endpoints_[j + 1];
-      endpoints_[SHELL_MAX_ENDPOINTS - 1] = 0;
-      break;
-    }
-  }
+  ShellEndpoint *endpoint = findEndpoint_(&stream);
+  if (!endpoint)
+    return;
+  removeEndpoint(*endpoint);
+  if (endpoint->owned)
+    delete endpoint;
+}
+
+ShellEndpoint *ShellController::findEndpoint_(Stream *stream)
+{
+  for (ShellEndpoint *e = endpoints_head_; e; e = e->next)
+    if (e->stream == stream)
+      return e;
+  return 0;
+}
+
+ShellFraming *ShellController::framingOf_(ShellEndpoint *endpoint)
+{
+  return (endpoint && endpoint->framing) ? endpoint->framing : framing_layer_;
+}
+
+void ShellController::markReady(ShellEndpoint &endpoint)
+{
+  if (endpoint.ready || !endpoint.notify || !endpoint.stream)
+    return;
+  endpoint.ready = true;
+  endpoint.ready_prev = ready_tail_;
+  endpoint.ready_next = 0;
+  if (ready_tail_)
+    ready_tail_->ready_next = &endpoint;
+  else
+    ready_head_ = &endpoint;
+  ready_tail_ = &endpoint;
+}
+
+void ShellController::unmarkReady_(ShellEndpoint *endpoint)
+{
+  if (!endpoint->ready)
+    return;
+  if (endpoint->ready_prev)
+    endpoint->ready_prev->ready_next = endpoint->ready_next;
+  else
+    ready_head_ = endpoint->ready_next;
+  if (endpoint->ready_next)
+    endpoint->ready_next->ready_prev = endpoint->ready_prev;
+  else
+    ready_tail_ = endpoint->ready_prev;
+  endpoint->ready = false;
+  endpoint->ready_prev = endpoint->ready_next = 0;
 }
 
 Stream *ShellController::getRequestingEndpoint()
@@ -194,9 +346,24 @@ size_t ShellController::write(uint8_t c)
   }
   else if (print_mode_ == PRINTMODE_RESPONDING)
   {
+#if SHELL_MAX_SCHEDULES > 0
+    response_hash_ = hashUpdate_(response_hash_, c);
+#endif
     if (requesting_endpoint_)
-      framing_layer_->send(requesting_endpoint_, c);
+      response_framing_->send(requesting_endpoint_, c);
+#if SHELL_ENDPOINT_STATS
+    if (requesting_node_)
+      requesting_node_->stats.bytes_out++;
+#endif
+  }
+#if SHELL_MAX_SCHEDULES > 0
+  else if (print_mode_ == PRINTMODE_HASHING)
+  {
+    response_hash_ = hashUpdate_(response_hash_, c);
+    if (schedule_response_len_ < SHELL_SCHEDULE_RESPONSE_LEN)
+      schedule_response_[schedule_response_len_++] = c;
   }
+#endif
   return 1;
 }
 
@@ -231,13 +398,18 @@ void ShellController::printHelp_(Print &out, PGM_P command_start_P, const char *
         // enters here when command is found or help is for ALL commands
         if (!cmd) // ALL
         {
+#if SHELL_HELP_TEXT
           // print command with spaces padded to the hend
           out.print(F_P(cmdp));
           int len = SHELL_HELP_ALIGN_MAX_COMMAND_LEN - strlen_P((PGM_P)cmdp);
           while (len-- > 0)
             out.write(' ');
           out.write(' ');
+#else
+          out.println(F_P(cmdp)); // only command names are listed
+#endif
         }
+#if SHELL_HELP_TEXT
         // Both ALL and SPECIFIC
         PGM_P hlptxtp = (PGM_P)pgm_read_ptr_near(command_start_P + sizeof(PGM_P) + sizeof(CommandHandlerFunc));
         // write until dot (included)
@@ -257,24 +429,40 @@ void ShellController::printHelp_(Print &out, PGM_P command_start_P, const char *
           out.print(F_P(hlptxtp)); // writes remaining chars after dot
           return;                  // SPECIFIC returns after found
         }
+#else
+        if (cmd) // SPECIFIC, there is nothing but the command itself to display
+        {
+          out.print(F_P(cmdp));
+          return;
+        }
+#endif
       }
       command_start_P += sizeof(ShellCommandStruct);
     }
   // ALL
   if (cmd)
     out.print(F_P(PSTR_SHELL_RESPONSE_ERR_BAD_COMMAND)); // Command not found
+#if SHELL_HELP_TEXT
   else
     out.println(F("\r\nFor more information on commands use HELP <cmd>."));
+#endif
 }
 
 void ShellController::printHelp(Print &out, bool admin, char *cmd)
 {
+#if SHELL_ADMIN_COMMANDS
   printHelp_(out, admin ? admin_command_start_P_ : user_command_start_P_, cmd);
+#else
+  printHelp_(out, admin ? 0 : user_command_start_P_, cmd);
+#endif
 }
 
 void ShellController::printError_(Print &out, int8_t errorcode)
 {
   out.print(F("ERR:"));
+#if !SHELL_ERROR_STRINGS
+  out.print(errorcode);
+#else
   int8_t index = errorcode;
   if (errorcode < 0)
     index = SHELL_RESPONSE_ERR_CUSTOM_PREFIX;
@@ -292,13 +480,22 @@ void ShellController::printError_(Print &out, int8_t errorcode)
   out.print(F_P(pgm_read_ptr_near(&(response_error_strings[index]))));
   if (errorcode < 0)
     out.print(errorcode);
+#endif
+}
+
+void ShellController::printError(Print &out, int8_t errorcode)
+{
+  printError_(out, errorcode);
 }
 
 void ShellController::beginResponse_(Print *out)
 {
   context_ = this;
   print_mode_ = PRINTMODE_RESPONDING;
-  framing_layer_->beginSend(out); //&_response_out
+  if (!requesting_node_) // set by receive_ for received commands
+    requesting_node_ = findEndpoint_(requesting_endpoint_);
+  response_framing_ = framingOf_(requesting_node_);
+  response_framing_->beginSend(out); //&_response_out
 }
 
 void ShellController::endResponse_(Print *out, int8_t error_code)
@@ -306,24 +503,29 @@ void ShellController::endResponse_(Print *out, int8_t error_code)
   if (error_code)
     printError_(*out, error_code);
   request_buf_ptr_ = &request_buf_[0];
-  framing_layer_->endSend(out); //&_response_out
+  response_framing_->endSend(out); //&_response_out
   if (requesting_endpoint_)
     requesting_endpoint_->flush(); // flush after command is executed, useful for buffered streams
   requesting_endpoint_ = 0;
+  requesting_node_ = 0;
   context_ = 0;
   print_mode_ = PRINTMODE_IGNORE;
+#if SHELL_FRAMING_SWITCH
   if (pending_framing_)
   {
     framing_layer_ = pending_framing_;
     pending_framing_ = 0;
   }
+#endif
 }
 
 ShellCommandStruct *ShellController::findCommandDefinition(char *command)
 {
   ShellCommandStruct *cmddef = findCommandStruct_P_((PGM_P)user_command_start_P_, command);
+#if SHELL_ADMIN_COMMANDS
   if (!cmddef)
     cmddef = findCommandStruct_P_((PGM_P)admin_command_start_P_, command);
+#endif
   return cmddef;
 }
 
@@ -350,9 +552,19 @@ int8_t ShellController::call(byte *command_line, Print &response)
   else
   {
     CommandHandlerFunc func = getFunctionByCommandStruct_P_(cmd);
+#if SHELL_TICK_PROFILER
+    tick_phase_ = SHELL_TICK_EXECUTE;
+    tick_command_ = cmd;
+#endif
+#if SHELL_MAX_COMMAND_STATS > 0
+    uint32_t start = micros();
+#endif
     int8_t ret = func(*request_, response);
     if (ret >= SHELL_RESPONSE_ERROR_COUNT)
       ret = SHELL_RESPONSE_ERR_UNKNOWN_ERROR;
+#if SHELL_MAX_COMMAND_STATS > 0
+    recordStats_(cmd, ret, micros() - start);
+#endif
     return ret;
   }
 }
@@ -371,58 +583,725 @@ void ShellController::exec(const __FlashStringHelper *command_line, Print &out)
   exec(start, out);
 }
 
-char *ShellController::available(bool greedy)
+char *ShellController::receive_(ShellEndpoint *endpoint, bool greedy)
 {
+#if SHELL_WORKER_THREADS > 0
+  if (endpoint->busy) // keeps the order of responses
+    return 0;
+#endif
+#if SHELL_TRANSFER
+  if (endpoint == transfer_node_) // read by the transfer
+    return 0;
+#endif
   byte *bufstart = &request_buf_[0];
-  print_mode_ = PRINTMODE_REQUESTING;
-  for (int8_t i = 0; i < SHELL_MAX_ENDPOINTS; i++)
+  Stream *s = endpoint->stream;
+  ShellFraming *framing = framingOf_(endpoint);
+#if SHELL_ENDPOINT_STATS
+  ShellEndpointStats *st = &endpoint->stats;
+#endif
+  while (s->available())
   {
-    Stream *s = endpoints_[i];
-    if (!s) // optimize for single endpoint (as endpoints are aligned to left, no need to iterate further)
-      break;
-    while (s->available())
+#if SHELL_TICK_PROFILER
+    tick_phase_ = SHELL_TICK_RECEIVE;
+#endif
+    char c = s->read();
+    int8_t rcvres = framing->receive(this, c);
+#if SHELL_ENDPOINT_STATS
+    st->bytes_in++;
+#endif
+    if (rcvres)
     {
-      char c = s->read();
-      int8_t rcvres = framing_layer_->receive(this, c);
-      if (rcvres)
+      requesting_endpoint_ = s;
+      requesting_node_ = endpoint;
+      int8_t errcode = 0;
+#if SHELL_ENDPOINT_STATS
+      uint16_t len = request_buf_ptr_ - bufstart;
+      st->frames++;
+      if (len > st->max_line_len)
+        st->max_line_len = len;
+#endif
+      if (rcvres < 0)
       {
-        requesting_endpoint_ = s;
-        int8_t errcode = 0;
-        if (rcvres < 0)
-        {
-          errcode = SHELL_RESPONSE_ERR_BAD_FRAME;
-        }
-        else if ((request_buf_ptr_ - bufstart) > SHELL_MAX_REQUEST_LEN)
-        {
-          errcode = SHELL_RESPONSE_ERR_COMMAND_TOO_LONG;
-        }
-        else
-        {
-          *request_buf_ptr_ = '\0'; // null termination
-          if (request_buf_ptr_ > bufstart)
-          { // empty command does not raise error
-            print_mode_ = PRINTMODE_IGNORE;
-            return (char *)bufstart;
-          }
+        errcode = SHELL_RESPONSE_ERR_BAD_FRAME;
+#if SHELL_ENDPOINT_STATS
+        st->bad_frames++;
+#endif
+      }
+      else if ((request_buf_ptr_ - bufstart) > SHELL_MAX_REQUEST_LEN)
+      {
+        errcode = SHELL_RESPONSE_ERR_COMMAND_TOO_LONG;
+#if SHELL_ENDPOINT_STATS
+        st->overlong_lines++;
+#endif
+      }
+      else
+      {
+        *request_buf_ptr_ = '\0'; // null termination
+        if (request_buf_ptr_ > bufstart)
+        { // empty command does not raise error
+          return (char *)bufstart;
         }
-        beginResponse_(this);
-        endResponse_(this, errcode);
+#if SHELL_ENDPOINT_STATS
+        st->empty_lines++;
+#endif
       }
-      if (!greedy)
-        break;
+      beginResponse_(this);
+      endResponse_(this, errcode);
+      print_mode_ = PRINTMODE_REQUESTING; // continue receiving after the error response
     }
+    if (!greedy)
+      break;
   }
-  print_mode_ = PRINTMODE_IGNORE;
   return 0;
 }
 
+char *ShellController::available(bool greedy)
+{
+  char *cmd = 0;
+  print_mode_ = PRINTMODE_REQUESTING;
+  // endpoints with notify are visited only when they are marked ready
+  for (ShellEndpoint *e = ready_head_; e && !cmd;)
+  {
+    ShellEndpoint *next = e->ready_next;
+    cmd = receive_(e, greedy);
+    if (!e->stream->available())
+      unmarkReady_(e);
+    e = next;
+  }
+  if (polled_count_)
+    for (ShellEndpoint *e = endpoints_head_; e && !cmd; e = e->next)
+      if (!e->notify)
+        cmd = receive_(e, greedy);
+  print_mode_ = PRINTMODE_IGNORE;
+  return cmd;
+}
+
 void ShellController::tick(bool greedy)
 {
+#if SHELL_TICK_PROFILER
+  uint32_t start = micros();
+  tick_phase_ = SHELL_TICK_IDLE;
+  tick_command_ = 0;
+#endif
+#if SHELL_WORKER_THREADS > 0
+  completeJobs_();
+#endif
   byte *cmdp = (byte *)available(greedy); // sets _requesting_stream internally
   if (cmdp)
   {
-    exec(cmdp, *this); //_response_out
+#if SHELL_WORKER_THREADS > 0
+    if (!dispatch_(cmdp))
+#endif
+      exec(cmdp, *this); //_response_out
+  }
+#if SHELL_INGRESS_QUEUE_LEN > 0
+  else if (runIngress_())
+  {
+    // posted commands run only when nothing is received
+  }
+#endif
+#if SHELL_MAX_SCHEDULES > 0
+  else
+    runSchedules_(); // only on idle ticks, so a single tick never executes more than one command
+#endif
+#if SHELL_TRANSFER
+  runTransfer_(); // after the response of the command starting it
+#endif
+#if SHELL_TASKS
+  runTasks_();
+#endif
+#if SHELL_EEPROM_QUEUE_LEN > 0
+  shellEepromPoll(); // no-op where the EE_READY interrupt drains the queue
+#endif
+#if SHELL_EVENT_BUFFER_SIZE > 0
+  flushEvents_();
+#endif
+#if SHELL_TICK_PROFILER
+  recordTick_(micros() - start);
+#endif
+}
+
+//******************* Transfer *****************************
+
+#if SHELL_TRANSFER
+
+bool ShellController::startTransfer(ShellTransfer *transfer)
+{
+  if (!requesting_node_ || transfer_)
+    return false;
+  transfer_ = transfer;
+  transfer_node_ = requesting_node_;
+  return true;
+}
+
+Stream *ShellController::getTransferEndpoint()
+{
+  return transfer_node_ ? transfer_node_->stream : 0;
+}
+
+void ShellController::runTransfer_()
+{
+  if (!transfer_)
+    return;
+#if SHELL_TICK_PROFILER
+  tick_phase_ = SHELL_TICK_EXECUTE;
+#endif
+  if (!transfer_->run(*transfer_node_->stream))
+  {
+    transfer_ = 0;
+    transfer_node_ = 0; // back to the framing layer
+  }
+}
+
+#endif
+
+//******************* Tasks ********************************
+
+#if SHELL_TASKS
+
+void ShellController::addTask(ShellTask &task)
+{
+  if (task.added_)
+    return;
+  task.next_ = tasks_;
+  task.added_ = true;
+  tasks_ = &task;
+}
+
+void ShellController::removeTask(ShellTask &task)
+{
+  for (ShellTask **p = &tasks_; *p; p = &(*p)->next_)
+    if (*p == &task)
+    {
+      *p = task.next_;
+      task.next_ = 0;
+      task.added_ = false;
+      return;
+    }
+}
+
+void ShellController::runTasks_()
+{
+  for (ShellTask *t = tasks_; t;)
+  {
+    ShellTask *next = t->next_; // t may remove itself
+    t->run();
+    t = next;
+  }
+}
+
+bool ShellController::beginEvent(Stream &endpoint)
+{
+  if (print_mode_ != PRINTMODE_IGNORE)
+    return false;
+  ShellEndpoint *e = findEndpoint_(&endpoint);
+  if (!e)
+    return false;
+#if SHELL_TRANSFER
+  if (e == transfer_node_)
+    return false;
+#endif
+  requesting_endpoint_ = &endpoint;
+  requesting_node_ = e;
+  response_framing_ = framingOf_(e);
+  print_mode_ = PRINTMODE_RESPONDING;
+#if SHELL_TICK_PROFILER
+  tick_phase_ = SHELL_TICK_EXECUTE;
+#endif
+  response_framing_->beginEvent(this);
+  return true;
+}
+
+void ShellController::endEvent()
+{
+  if (print_mode_ != PRINTMODE_RESPONDING)
+    return;
+  response_framing_->endEvent(this);
+  requesting_endpoint_->flush();
+  requesting_endpoint_ = 0;
+  requesting_node_ = 0;
+  print_mode_ = PRINTMODE_IGNORE;
+}
+
+#endif
+
+//******************* Scheduler ****************************
+
+#if SHELL_MAX_SCHEDULES > 0
+
+uint16_t ShellController::hashUpdate_(uint16_t hash, uint8_t c)
+{
+  return ((hash << 5) + hash) ^ c;
+}
+
+int8_t ShellController::schedule(uint32_t interval, const char *command_line, Stream *endpoint, bool change_only)
+{
+  if (!endpoint || !interval || strlen(command_line) > SHELL_SCHEDULE_COMMAND_LEN)
+    return -SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+  for (int8_t i = 0; i < SHELL_MAX_SCHEDULES; i++)
+  {
+    ShellSchedule *s = &schedules_[i];
+    if (s->endpoint)
+      continue;
+    strcpy(s->command, command_line);
+    // command name is validated here, instead of reporting the same error on every run
+    char *space = strchr(s->command, ' ');
+    if (space)
+      *space = '\0';
+    bool found = findCommandDefinition(s->command) != 0;
+    if (space)
+      *space = ' ';
+    if (!found)
+      return -SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    s->endpoint = endpoint;
+    s->interval = interval;
+    s->last_run = millis() - interval; // first run is on the next idle tick
+    s->last_hash = 0;
+    s->change_only = change_only;
+    return i;
+  }
+  return -SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+}
+
+void ShellController::unschedule(int8_t slot)
+{
+  for (int8_t i = 0; i < SHELL_MAX_SCHEDULES; i++)
+    if (slot < 0 || slot == i)
+      schedules_[i].endpoint = 0;
+}
+
+void ShellController::printSchedules(Print &out)
+{
+  bool first = true;
+  for (int8_t i = 0; i < SHELL_MAX_SCHEDULES; i++)
+  {
+    ShellSchedule *s = &schedules_[i];
+    if (!s->endpoint)
+      continue;
+    if (!first)
+      out.println();
+    first = false;
+    out.print(i);
+    out.write(' ');
+    out.print(s->interval);
+    out.print(s->change_only ? F(" -c ") : F(" "));
+    out.print(s->command);
+  }
+}
+
+void ShellController::runSchedules_()
+{
+  uint32_t now = millis();
+  for (int8_t n = 0; n < SHELL_MAX_SCHEDULES; n++)
+  {
+    ShellSchedule *s = &schedules_[next_schedule_];
+    if (++next_schedule_ >= SHELL_MAX_SCHEDULES)
+      next_schedule_ = 0;
+#if SHELL_TRANSFER
+    if (transfer_node_ && s->endpoint == transfer_node_->stream)
+      continue; // would corrupt the transfer, resumes after it
+#endif
+    if (s->endpoint && now - s->last_run >= s->interval)
+    {
+      s->last_run += s->interval;
+      if (now - s->last_run >= s->interval) // fell behind, do not burst to catch up
+        s->last_run = now;
+      runSchedule_(s);
+      return; // one command per tick, round robin between slots
+    }
+  }
+}
+
+void ShellController::runSchedule_(ShellSchedule *s)
+{
+  // command is parsed in place, so it runs on a copy and the partially received request is preserved
+  byte line[SHELL_SCHEDULE_COMMAND_LEN + 1];
+  byte *request_buf_ptr = request_buf_ptr_;
+  int8_t errcode;
+  requesting_endpoint_ = s->endpoint;
+  strcpy((char *)line, s->command);
+  if (s->change_only)
+  {
+    // the command runs once, its response is buffered while hashed and sent only if the hash differs
+    context_ = this;
+    print_mode_ = PRINTMODE_HASHING;
+    response_hash_ = 0;
+    schedule_response_len_ = 0;
+    errcode = call(line, *this);
+    print_mode_ = PRINTMODE_IGNORE;
+    context_ = 0;
+    uint16_t hash = hashUpdate_(response_hash_, errcode);
+    if (hash == s->last_hash)
+    {
+      requesting_endpoint_ = 0;
+      return;
+    }
+    beginResponse_(this);
+    for (uint16_t i = 0; i < schedule_response_len_; i++)
+      write(schedule_response_[i]);
+    s->last_hash = hash;
+    endResponse_(this, errcode);
+    request_buf_ptr_ = request_buf_ptr;
+    return;
+  }
+  beginResponse_(this);
+  response_hash_ = 0; // frame header is not hashed
+  errcode = call(line, *this);
+  s->last_hash = hashUpdate_(response_hash_, errcode);
+  endResponse_(this, errcode);
+  request_buf_ptr_ = request_buf_ptr;
+}
+
+#endif
+
+//******************* Statistics ****************************
+
+#if SHELL_MAX_COMMAND_STATS > 0
+
+void ShellController::recordStats_(ShellCommandStruct *cmd, int8_t errorcode, uint32_t duration_us)
+{
+  for (uint8_t i = 0; i < SHELL_MAX_COMMAND_STATS; i++)
+  {
+    ShellCommandStats *st = &command_stats_[i];
+    if (st->command && st->command != cmd)
+      continue;
+    st->command = cmd; // assigns a free entry on first execution
+    st->calls++;
+    if (errorcode)
+    {
+      uint8_t index = errorcode;
+      if (errorcode < 0)
+        index = SHELL_RESPONSE_ERR_CUSTOM_PREFIX;
+      else if (errorcode >= SHELL_RESPONSE_ERROR_COUNT)
+        index = SHELL_RESPONSE_ERROR_COUNT;
+      if (st->errors[index] != 0xffff) // saturates instead of wrapping
+        st->errors[index]++;
+    }
+    st->total_us += duration_us;
+    if (duration_us > st->max_us)
+      st->max_us = duration_us;
+    return;
   }
+  // table is full, command is not recorded
+}
+
+const ShellCommandStats *ShellController::getCommandStats(uint8_t index)
+{
+  if (index >= SHELL_MAX_COMMAND_STATS || !command_stats_[index].command)
+    return 0;
+  return &command_stats_[index];
+}
+
+void ShellController::resetCommandStats()
+{
+  memset(command_stats_, 0, sizeof(command_stats_));
 }
 
+#endif
+
+#if SHELL_ENDPOINT_STATS
+
+const ShellEndpointStats *ShellController::getEndpointStats(Stream &stream)
+{
+  ShellEndpoint *endpoint = findEndpoint_(&stream);
+  return endpoint ? &endpoint->stats : 0;
+}
+
+const ShellEndpointStats *ShellController::getEndpointStats(uint8_t index)
+{
+  ShellEndpoint *e = endpoints_head_;
+  while (e && index--)
+    e = e->next;
+  return e ? &e->stats : 0;
+}
+
+void ShellController::resetEndpointStats()
+{
+  for (ShellEndpoint *e = endpoints_head_; e; e = e->next)
+    memset(&e->stats, 0, sizeof(ShellEndpointStats));
+}
+
+#endif
+
+#if SHELL_TICK_PROFILER
+
+void ShellController::recordTick_(uint32_t duration_us)
+{
+  uint8_t bucket = 0;
+  for (uint32_t us = duration_us; us > 1 && bucket < SHELL_TICK_PROFILE_BUCKETS - 1; us >>= 1)
+    bucket++;
+  uint16_t *count = &tick_profile_.histogram[tick_phase_][bucket];
+  if (*count != 0xffff) // saturates instead of wrapping
+    (*count)++;
+  if (duration_us >= tick_profile_.max_us[tick_phase_]) // fast ticks may take 0 us
+  {
+    tick_profile_.max_us[tick_phase_] = duration_us;
+    if (tick_phase_ == SHELL_TICK_EXECUTE)
+      tick_profile_.max_command = tick_command_;
+  }
+}
+
+const ShellTickProfile *ShellController::getTickProfile()
+{
+  return &tick_profile_;
+}
+
+void ShellController::resetTickProfile()
+{
+  memset(&tick_profile_, 0, sizeof(tick_profile_));
+}
+
+#endif
+
+//******************* Worker Threads ****************************
+
+#if SHELL_WORKER_THREADS > 0
+
+ShellExecutor *ShellController::getExecutor()
+{
+  return executor_;
+}
+
+bool ShellController::dispatch_(byte *command_line)
+{
+  if (!executor_ || !requesting_node_)
+    return false;
+  ShellJob *job = new ShellJob();
+  strcpy((char *)job->line, (char *)command_line); // parsing below modifies the line
+  char *cmdstart;
+  request_->begin(command_line);
+  request_->readString(&cmdstart, true);
+  ShellCommandStruct *cmd = findCommandDefinition(cmdstart);
+  if (!cmd || !(pgm_read_byte_near(&cmd->flags) & SHELL_COMMAND_FLAG_THREADSAFE))
+  {
+    strcpy((char *)command_line, (char *)job->line);
+    delete job;
+    return false;
+  }
+  job->session = requesting_node_;
+  job->stream = requesting_endpoint_;
+  job->command = cmd;
+  job->handler = getFunctionByCommandStruct_P_(cmd);
+  requesting_node_->busy = true;
+  requesting_endpoint_ = 0;
+  requesting_node_ = 0;
+  request_buf_ptr_ = &request_buf_[0];
+  executor_->submit(job);
+  return true;
+}
+
+void ShellController::completeJobs_()
+{
+  ShellJob *job;
+  while (executor_ && (job = executor_->completed()) != 0)
+  {
+    // removeEndpoint() clears the session if the endpoint was removed while its command was running
+    ShellEndpoint *endpoint = job->session;
+    if (endpoint)
+    {
+      byte *request_buf_ptr = request_buf_ptr_;
+      int8_t errcode = job->result;
+      if (errcode >= SHELL_RESPONSE_ERROR_COUNT)
+        errcode = SHELL_RESPONSE_ERR_UNKNOWN_ERROR;
+      endpoint->busy = false;
+      requesting_endpoint_ = job->stream;
+      requesting_node_ = endpoint;
+#if SHELL_TICK_PROFILER
+      tick_phase_ = SHELL_TICK_EXECUTE;
+      tick_command_ = job->command;
+#endif
+#if SHELL_MAX_COMMAND_STATS > 0
+      recordStats_(job->command, errcode, job->duration_us); // statistics are not thread safe
+#endif
+      beginResponse_(this);
+      for (size_t i = 0; i < job->response.size(); i++)
+        write(job->response[i]);
+      endResponse_(this, errcode);
+      request_buf_ptr_ = request_buf_ptr;
+    }
+    delete job;
+  }
+}
+
+#endif
+
+//******************* Ingress Queue ****************************
+
+#if SHELL_INGRESS_QUEUE_LEN > 0
+
+#if defined(__AVR__)
+// barriers keep the buffer accesses on the right side of the index accesses
+static inline uint8_t ingressLoad(ShellIngressIndex &index)
+{
+  uint8_t value = index;
+  __asm__ __volatile__("" ::: "memory");
+  return value;
+}
+
+static inline void ingressStore(ShellIngressIndex &index, uint8_t value)
+{
+  __asm__ __volatile__("" ::: "memory");
+  index = value;
+}
+#else
+static inline uint16_t ingressLoad(ShellIngressIndex &index)
+{
+  return index.load(std::memory_order_acquire);
+}
+
+static inline void ingressStore(ShellIngressIndex &index, uint16_t value)
+{
+  index.store(value, std::memory_order_release);
+}
+#endif
+
+bool ShellController::post(const char *command_line)
+{
+  return postIngress_(command_line, false);
+}
+
+bool ShellController::post(const __FlashStringHelper *command_line)
+{
+  return postIngress_((PGM_P)command_line, true);
+}
+
+void ShellController::setIngressOutput(Print *out)
+{
+  ingress_out_ = out;
+}
+
+bool ShellController::postIngress_(const char *command_line, bool progmem)
+{
+  uint16_t len = progmem ? strlen_P(command_line) : strlen(command_line);
+  if (len == 0 || len > SHELL_MAX_REQUEST_LEN)
+    return false;
+  uint16_t head = ingress_head_;
+  uint16_t used = (head + SHELL_INGRESS_QUEUE_LEN - ingressLoad(ingress_tail_)) % SHELL_INGRESS_QUEUE_LEN;
+  if (len + 1 > SHELL_INGRESS_QUEUE_LEN - 1 - used) // one cell is kept empty to distinguish full from empty
+    return false;
+  for (uint16_t i = 0; i <= len; i++)
+  {
+    if (i < len)
+      ingress_[head] = progmem ? pgm_read_byte_near(command_line++) : *(command_line++);
+    else
+      ingress_[head] = '\0';
+    if (++head >= SHELL_INGRESS_QUEUE_LEN)
+      head = 0;
+  }
+  ingressStore(ingress_head_, head); // line becomes visible to tick() when it is complete
+  return true;
+}
+
+bool ShellController::runIngress_()
+{
+  uint16_t tail = ingress_tail_;
+  if (tail == ingressLoad(ingress_head_))
+    return false;
+  // copied out, so the slot is free while the command runs and the partially received request is preserved
+  byte line[SHELL_MAX_REQUEST_LEN + 1];
+  byte *p = line;
+  do
+  {
+    *p = ingress_[tail];
+    if (++tail >= SHELL_INGRESS_QUEUE_LEN)
+      tail = 0;
+  } while (*(p++));
+  ingressStore(ingress_tail_, tail);
+  byte *request_buf_ptr = request_buf_ptr_;
+  if (ingress_out_)
+    exec(line, *ingress_out_);
+  else
+    exec(line, *this); // no requesting endpoint, response is dropped
+  request_buf_ptr_ = request_buf_ptr;
+  return true;
+}
+
+#endif
+
+//******************* Events ****************************
+
+#if SHELL_EVENT_BUFFER_SIZE > 0
+
+bool ShellController::emitEvent(const char *text, Stream *endpoint)
+{
+  return pushEvent_(text, false, endpoint);
+}
+
+bool ShellController::emitEvent(const __FlashStringHelper *text, Stream *endpoint)
+{
+  return pushEvent_((PGM_P)text, true, endpoint);
+}
+
+bool ShellController::pushEvent_(const char *text, bool progmem, Stream *endpoint)
+{
+  uint16_t used = (events_head_ + SHELL_EVENT_BUFFER_SIZE - events_tail_) % SHELL_EVENT_BUFFER_SIZE;
+  uint16_t len = progmem ? strlen_P(text) : strlen(text);
+  uint16_t size = sizeof(endpoint) + len + 1;
+  if (size > SHELL_EVENT_BUFFER_SIZE - 1 - used) // one cell is kept empty to distinguish full from empty
+    return false;
+  uint8_t head = events_head_;
+  byte *p = (byte *)&endpoint;
+  for (uint16_t i = 0; i < size; i++)
+  {
+    if (i < sizeof(endpoint))
+      events_[head] = p[i];
+    else if (i < sizeof(endpoint) + len)
+      events_[head] = progmem ? pgm_read_byte_near(text++) : *(text++);
+    else
+      events_[head] = '\0';
+    if (++head >= SHELL_EVENT_BUFFER_SIZE)
+      head = 0;
+  }
+  events_head_ = head; // event becomes visible to flushEvents_ when it is complete
+  return true;
+}
+
+void ShellController::flushEvents_()
+{
+  while (events_tail_ != events_head_)
+  {
+    Stream *endpoint;
+    byte *p = (byte *)&endpoint;
+    for (uint8_t i = 0; i < sizeof(endpoint); i++)
+    {
+      p[i] = events_[events_tail_];
+      if (++events_tail_ >= SHELL_EVENT_BUFFER_SIZE)
+        events_tail_ = 0;
+    }
+    uint8_t text = events_tail_;
+    // events are sent only to registered endpoints, the target might have been removed after queueing
+    for (ShellEndpoint *e = endpoints_head_; e; e = e->next)
+    {
+      Stream *s = e->stream;
+      if (endpoint && endpoint != s)
+        continue;
+#if SHELL_TRANSFER
+      if (e == transfer_node_) // not delivered to an endpoint running a transfer
+        continue;
+#endif
+      requesting_endpoint_ = s;
+      requesting_node_ = e;
+      response_framing_ = framingOf_(e);
+      print_mode_ = PRINTMODE_RESPONDING;
+#if SHELL_TICK_PROFILER
+      tick_phase_ = SHELL_TICK_EXECUTE;
+#endif
+      response_framing_->beginEvent(this);
+      for (uint8_t j = text; events_[j]; j = (j + 1) % SHELL_EVENT_BUFFER_SIZE)
+        write(events_[j]);
+      response_framing_->endEvent(this);
+      s->flush();
+    }
+    // skip text including the null termination
+    while (events_[events_tail_])
+      events_tail_ = (events_tail_ + 1) % SHELL_EVENT_BUFFER_SIZE;
+    events_tail_ = (events_tail_ + 1) % SHELL_EVENT_BUFFER_SIZE;
+  }
+  requesting_endpoint_ = 0;
+  requesting_node_ = 0;
+  print_mode_ = PRINTMODE_IGNORE;
+}
+
+#endif
+
 ShellController Shell; // create object
@@ -27,26 +27,33 @@ SOFTWARE.
 #include <Arduino.h>
 #include <ShellCommon.h>
 #include "ShellFraming.h"
-
-#if !defined(SHELL_MAX_REQUEST_LEN)
-#define SHELL_MAX_REQUEST_LEN 80
+#if SHELL_TRANSFER
+#include "ShellTransfer.h"
 #endif
-
-#if !defined(SHELL_HELP_ALIGN_MAX_COMMAND_LEN)
-#define SHELL_HELP_ALIGN_MAX_COMMAND_LEN 9
+#if SHELL_TASKS
+#include "ShellTask.h"
 #endif
 
-#if !defined(SHELL_MAX_ENDPOINTS)
-#define SHELL_MAX_ENDPOINTS 4
+#if SHELL_INGRESS_QUEUE_LEN > 0
+#if defined(__AVR__)
+typedef volatile uint8_t ShellIngressIndex; // single byte accesses are atomic
+#else
+#include <atomic>
+typedef std::atomic<uint16_t> ShellIngressIndex;
 #endif
-
-// By default backspace is defined as BS=8 character, make it NUL=0 to disable
-#if !defined(SHELL_BACKSPACE_CHAR)
-#define SHELL_BACKSPACE_CHAR 8
 #endif
 
+// These error codes should be sequential in DESCENDING order, start should be 0x7f
+const int8_t SHELL_RESPONSE_ERR_UNKNOWN_ERROR = 127;
+const int8_t SHELL_RESPONSE_ERR_BAD_COMMAND = 126;
+const int8_t SHELL_RESPONSE_ERR_COMMAND_TOO_LONG = 125;
+const int8_t SHELL_RESPONSE_ERR_BAD_FRAME = 124;
+// remember to increment count if new system commands are defined
+#define SHELL_RESPONSE_SYSTEM_ERROR_COUNT 4
+
 const char PSTR_SHELL_RESPONSE_ERR_PREFIX[] PROGMEM = "ERR:";
 
+#if SHELL_ERROR_STRINGS
 const char PSTR_SHELL_RESPONSE_ERR_CUSTOM_PREFIX[] PROGMEM = "Custom-Error";
 const char PSTR_SHELL_RESPONSE_ERR_BAD_ARGUMENT[] PROGMEM = "Bad or missing argument";
 const char PSTR_SHELL_RESPONSE_ERR_TIMEOUT[] PROGMEM = "Operation timed out";
@@ -66,6 +73,86 @@ const char *const response_error_strings[SHELL_RESPONSE_ERROR_COUNT] PROGMEM =
         PSTR_SHELL_RESPONSE_ERR_COMMUNICATION_FAULT,
         PSTR_SHELL_RESPONSE_ERR_ILLEGAL_OPERATION,
 };
+#endif
+
+#if SHELL_MAX_SCHEDULES > 0
+struct ShellSchedule
+{
+    Stream *endpoint; // responses are sent to this endpoint, null if slot is free
+    uint32_t interval;
+    uint32_t last_run;
+    uint16_t last_hash; // hash of the last emitted response, used in change-only mode
+    bool change_only;
+    char command[SHELL_SCHEDULE_COMMAND_LEN + 1];
+};
+#endif
+
+#if SHELL_MAX_COMMAND_STATS > 0
+// entries are assigned to commands in order of first execution
+struct ShellCommandStats
+{
+    ShellCommandStruct *command; // null if entry is free
+    uint32_t calls;
+    uint16_t errors[SHELL_RESPONSE_ERROR_COUNT + 1]; // indexed by error code, 0 is custom, last is unknown
+    uint32_t total_us;
+    uint32_t max_us;
+};
+#endif
+
+#if SHELL_ENDPOINT_STATS
+struct ShellEndpointStats
+{
+    uint32_t bytes_in;
+    uint32_t bytes_out; // bytes passed to the framing layer
+    uint32_t frames;    // all received frames, including bad, overlong and empty ones
+    uint16_t bad_frames;
+    uint16_t overlong_lines;
+    uint16_t empty_lines;
+    uint16_t max_line_len; // may exceed SHELL_MAX_REQUEST_LEN
+};
+#endif
+
+// Endpoint list node, allocated by the caller and valid until it is removed.
+// Endpoints added with notify are not polled, their transport calls markReady() when data arrives.
+struct ShellEndpoint
+{
+    Stream *stream;        // null if not added
+    ShellFraming *framing; // null uses the controller framing
+    ShellEndpoint *prev;
+    ShellEndpoint *next;
+    ShellEndpoint *ready_prev;
+    ShellEndpoint *ready_next;
+    bool notify;
+    bool ready; // in the ready list
+    bool owned; // allocated by addEndpoint(Stream &)
+#if SHELL_WORKER_THREADS > 0
+    bool busy; // a command of this endpoint runs on a worker thread, not read until it completes
+#endif
+#if SHELL_ENDPOINT_STATS
+    ShellEndpointStats stats;
+#endif
+    ShellEndpoint() : stream(0) {} // the other members are set by addEndpoint()
+};
+
+#if SHELL_TICK_PROFILER
+#define SHELL_TICK_PROFILE_BUCKETS 16
+#define SHELL_TICK_PHASE_COUNT 3
+// tick phases, the phase of a tick is the highest one reached
+const uint8_t SHELL_TICK_IDLE = 0;    // nothing received
+const uint8_t SHELL_TICK_RECEIVE = 1; // bytes received, nothing executed
+const uint8_t SHELL_TICK_EXECUTE = 2; // a command was executed or events were sent
+struct ShellTickProfile
+{
+    // bucket n counts ticks that took [2^n, 2^(n+1)) us, bucket 0 includes 0 us and the last one has no upper limit
+    uint16_t histogram[SHELL_TICK_PHASE_COUNT][SHELL_TICK_PROFILE_BUCKETS];
+    uint32_t max_us[SHELL_TICK_PHASE_COUNT];
+    ShellCommandStruct *max_command; // command executed in the slowest execute tick
+};
+#endif
+
+#if SHELL_WORKER_THREADS > 0
+class ShellExecutor;
+#endif
 
 class ShellController : public Print
 {
@@ -73,12 +160,22 @@ private:
     uint8_t print_mode_; // share this instance of ShellController as Print for RAM optimization
     ShellFraming *framing_layer_;
     ShellFraming *default_cmd_framing_;
+#if SHELL_FRAMING_SWITCH
     ShellFraming *pending_framing_;
+#endif
     ArgumentReader *request_;
-    Stream *endpoints_[SHELL_MAX_ENDPOINTS];
+    ShellEndpoint *endpoints_head_;
+    ShellEndpoint *endpoints_tail_;
+    ShellEndpoint *ready_head_;
+    ShellEndpoint *ready_tail_;
+    uint16_t polled_count_; // endpoints without notify
     Stream *requesting_endpoint_;
+    ShellEndpoint *requesting_node_; // null if the response is not sent to an endpoint
+    ShellFraming *response_framing_;
     PGM_P user_command_start_P_;
+#if SHELL_ADMIN_COMMANDS
     PGM_P admin_command_start_P_;
+#endif
     byte request_buf_[SHELL_MAX_REQUEST_LEN + 1]; //+1 for null termination
     byte *request_buf_ptr_;
     static ShellCommandStruct *findCommandStruct_P_(PGM_P command_start_P, char *cmd);
@@ -88,17 +185,79 @@ private:
     void endExecute_();
     void beginResponse_(Print *out);
     void endResponse_(Print *out, int8_t error_code = SHELL_RESPONSE_OK);
+    ShellEndpoint *findEndpoint_(Stream *stream);
+    ShellFraming *framingOf_(ShellEndpoint *endpoint);
+    void unmarkReady_(ShellEndpoint *endpoint);
+    char *receive_(ShellEndpoint *endpoint, bool greedy);
+#if SHELL_MAX_SCHEDULES > 0
+    ShellSchedule schedules_[SHELL_MAX_SCHEDULES];
+    uint8_t next_schedule_;
+    uint16_t response_hash_;
+    byte schedule_response_[SHELL_SCHEDULE_RESPONSE_LEN]; // response of a change-only schedule
+    uint16_t schedule_response_len_;
+    static uint16_t hashUpdate_(uint16_t hash, uint8_t c);
+    void runSchedules_();
+    void runSchedule_(ShellSchedule *s);
+#endif
+#if SHELL_MAX_COMMAND_STATS > 0
+    ShellCommandStats command_stats_[SHELL_MAX_COMMAND_STATS];
+    void recordStats_(ShellCommandStruct *cmd, int8_t errorcode, uint32_t duration_us);
+#endif
+#if SHELL_TICK_PROFILER
+    ShellTickProfile tick_profile_;
+    uint8_t tick_phase_;
+    ShellCommandStruct *tick_command_;
+    void recordTick_(uint32_t duration_us);
+#endif
+#if SHELL_INGRESS_QUEUE_LEN > 0
+    byte ingress_[SHELL_INGRESS_QUEUE_LEN]; // null terminated command lines
+    ShellIngressIndex ingress_head_;        // written by the producer only
+    ShellIngressIndex ingress_tail_;        // written by tick() only
+    Print *ingress_out_;
+    bool postIngress_(const char *command_line, bool progmem);
+    bool runIngress_();
+#endif
+#if SHELL_TRANSFER
+    ShellTransfer *transfer_;
+    ShellEndpoint *transfer_node_;
+    void runTransfer_();
+#endif
+#if SHELL_TASKS
+    ShellTask *tasks_;
+    void runTasks_();
+#endif
+#if SHELL_WORKER_THREADS > 0
+    ShellExecutor *executor_;
+    bool dispatch_(byte *command_line);
+    void completeJobs_();
+#endif
+#if SHELL_EVENT_BUFFER_SIZE > 0
+    byte events_[SHELL_EVENT_BUFFER_SIZE]; // each event is stored as target endpoint pointer + null terminated text
+    uint8_t events_head_;
+    uint8_t events_tail_;
+    bool pushEvent_(const char *text, bool progmem, Stream *endpoint);
+    void flushEvents_();
+#endif
 
 public:
     static ShellController *context();
     ShellController();
     void begin(const ShellCommandStruct user_commands[], const __FlashStringHelper *prompt = 0);
     void setUserCommands(const ShellCommandStruct user_commands[]);
+#if SHELL_ADMIN_COMMANDS
     void setAdminCommands(const ShellCommandStruct admin_commands[]);
-    void addEndpoint(Stream &stream);
+#endif
+    // O(1), endpoint node is provided by the caller. framing is used only for this endpoint, null uses the controller framing
+    void addEndpoint(ShellEndpoint &endpoint, Stream &stream, bool notify = false, ShellFraming *framing = 0);
+    void removeEndpoint(ShellEndpoint &endpoint);
+    // allocates the node, O(endpoints)
+    void addEndpoint(Stream &stream, ShellFraming *framing = 0);
     void removeEndpoint(Stream &stream);
+    // makes tick() visit an endpoint added with notify, not safe to be called from ISRs
+    void markReady(ShellEndpoint &endpoint);
     Stream *getRequestingEndpoint();
     void printHelp(Print &out, bool admin, char *cmd = 0);
+    void printError(Print &out, int8_t errorcode);
 
     void tick(bool greedy = true);
     int8_t call(byte *command_line, Print &response);
@@ -108,8 +267,61 @@ public:
     char *available(bool greedy);
     ShellCommandStruct *findCommandDefinition(char *command);
     CommandHandlerFunc findCommandFunction(char *command);
+#if SHELL_FRAMING_SWITCH
+    // switches the controller framing after the current response, endpoints added with their own framing keep it
     void setFraming(ShellFraming *framing);
+#endif
     virtual size_t write(uint8_t c);
+#if SHELL_MAX_SCHEDULES > 0
+    // returns slot index, or negated SHELL_RESPONSE_ERR_* code on failure
+    int8_t schedule(uint32_t interval, const char *command_line, Stream *endpoint, bool change_only = false);
+    void unschedule(int8_t slot); // -1 clears all slots
+    void printSchedules(Print &out);
+#endif
+#if SHELL_MAX_COMMAND_STATS > 0
+    const ShellCommandStats *getCommandStats(uint8_t index); // null if index is out of range or unused
+    void resetCommandStats();
+#endif
+#if SHELL_ENDPOINT_STATS
+    const ShellEndpointStats *getEndpointStats(Stream &stream); // null if stream is not an endpoint
+    const ShellEndpointStats *getEndpointStats(uint8_t index);  // in order of addition
+    void resetEndpointStats();
+#endif
+#if SHELL_TICK_PROFILER
+    const ShellTickProfile *getTickProfile();
+    void resetTickProfile();
+#endif
+#if SHELL_EVENT_BUFFER_SIZE > 0
+    // queues a notification to be sent by tick() between responses, null endpoint means all endpoints
+    // returns false if the event does not fit, not safe to be called from ISRs
+    bool emitEvent(const char *text, Stream *endpoint = 0);
+    bool emitEvent(const __FlashStringHelper *text, Stream *endpoint = 0);
+#endif
+#if SHELL_INGRESS_QUEUE_LEN > 0
+    // queues a command line to be executed by tick() when nothing is received, returns false if it does not fit.
+    // lock free single producer queue, safe to be called from a single ISR or thread other than the one calling tick()
+    bool post(const char *command_line);
+    bool post(const __FlashStringHelper *command_line);
+    // responses of posted commands are sent to out, null discards them
+    void setIngressOutput(Print *out);
+#endif
+#if SHELL_TRANSFER
+    // hands the requesting endpoint to transfer after the current response, until its run() returns false.
+    // returns false if the command was not received from an endpoint or a transfer is already running
+    bool startTransfer(ShellTransfer *transfer);
+    Stream *getTransferEndpoint(); // null if no transfer is running
+#endif
+#if SHELL_TASKS
+    void addTask(ShellTask &task); // runs on every tick until removed
+    void removeTask(ShellTask &task);
+    // sends an event directly to an endpoint, the text is printed to the controller between the two calls.
+    // returns false during a response or if the stream is not an endpoint (or runs a transfer)
+    bool beginEvent(Stream &endpoint);
+    void endEvent();
+#endif
+#if SHELL_WORKER_THREADS > 0
+    ShellExecutor *getExecutor(); // created by begin()
+#endif
 };
 
 extern ShellController Shell;
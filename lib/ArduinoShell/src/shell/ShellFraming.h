@@ -56,6 +56,9 @@ public:
         out->write(c);
     }
     virtual void endSend(Print *out) {} // send frame trailer, checksum etc.
+    // EVENT (unsolicited notification, never sent while a response is in progress)
+    virtual void beginEvent(Print *out) { beginSend(out); } // send event frame header
+    virtual void endEvent(Print *out) { endSend(out); }     // send event frame trailer
 };
 
 #endif //_SHELL_FRAMING_H_
@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellRecorder.h"
+
+ShellRecorder::ShellRecorder(Stream &stream, Print &trace)
+{
+  stream_ = &stream;
+  trace_ = &trace;
+  chunk_type_ = 0;
+  chunk_len_ = 0;
+  trace_->write('S');
+  trace_->write('R');
+  trace_->write(SHELL_TRACE_VERSION);
+  last_time_ = micros();
+}
+
+void ShellRecorder::writeVarint_(uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    trace_->write((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  trace_->write((uint8_t)value);
+}
+
+void ShellRecorder::sync()
+{
+  if (!chunk_type_)
+    return;
+  trace_->write(chunk_type_);
+  writeVarint_(chunk_time_ - last_time_);
+  writeVarint_(chunk_len_);
+  trace_->write(chunk_, chunk_len_);
+  last_time_ = chunk_time_;
+  chunk_type_ = 0;
+  chunk_len_ = 0;
+}
+
+void ShellRecorder::record_(uint8_t type, uint8_t c)
+{
+  uint32_t now = micros();
+  if (chunk_type_ && (chunk_type_ != type || chunk_len_ >= SHELL_RECORDER_CHUNK_LEN || now - chunk_time_ > SHELL_RECORDER_MERGE_US))
+    sync();
+  if (!chunk_type_)
+  {
+    chunk_type_ = type;
+    chunk_time_ = now;
+  }
+  chunk_[chunk_len_++] = c;
+}
+
+int ShellRecorder::read()
+{
+  int c = stream_->read();
+  if (c >= 0)
+    record_(SHELL_TRACE_INBOUND, c);
+  return c;
+}
+
+size_t ShellRecorder::write(uint8_t c)
+{
+  size_t n = stream_->write(c);
+  if (n)
+    record_(SHELL_TRACE_OUTBOUND, c);
+  return n;
+}
+
+void ShellRecorder::flush()
+{
+  sync();
+  stream_->flush();
+}
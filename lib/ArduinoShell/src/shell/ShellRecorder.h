@@ -0,0 +1,78 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_RECORDER_H_
+#define _SHELL_RECORDER_H_
+
+#include <Arduino.h>
+
+// Stream wrapper which records the traffic of an endpoint to a compact binary trace.
+// Add the recorder with addEndpoint() instead of the wrapped stream.
+//
+// Trace format:
+//   header: 'S' 'R' <version>
+//   record: <type> <delta us, varint> <length, varint> <bytes>
+// delta is the time since the previous record, varints are 7 bits per byte, least significant first.
+// Consecutive bytes in the same direction are merged into a single record.
+
+#if !defined(SHELL_RECORDER_CHUNK_LEN)
+#define SHELL_RECORDER_CHUNK_LEN 32 // maximum bytes in a single record
+#endif
+
+#if !defined(SHELL_RECORDER_MERGE_US)
+#define SHELL_RECORDER_MERGE_US 1000 // bytes further apart start a new record
+#endif
+
+const uint8_t SHELL_TRACE_VERSION = 1;
+const uint8_t SHELL_TRACE_INBOUND = 1;  // received from the endpoint
+const uint8_t SHELL_TRACE_OUTBOUND = 2; // sent to the endpoint
+
+class ShellRecorder : public Stream
+{
+private:
+    Stream *stream_;
+    Print *trace_;
+    uint32_t last_time_;
+    uint32_t chunk_time_;
+    uint8_t chunk_type_; // 0 when empty
+    uint8_t chunk_len_;
+    uint8_t chunk_[SHELL_RECORDER_CHUNK_LEN];
+
+    void writeVarint_(uint32_t value);
+    void record_(uint8_t type, uint8_t c);
+
+public:
+    ShellRecorder(Stream &stream, Print &trace);
+    // writes the pending record, call before the trace is closed or read
+    void sync();
+
+    virtual int available() { return stream_->available(); }
+    virtual int peek() { return stream_->peek(); }
+    virtual int read();
+    virtual int availableForWrite() { return stream_->availableForWrite(); }
+    virtual size_t write(uint8_t c);
+    virtual void flush();
+    using Print::write;
+};
+
+#endif //_SHELL_RECORDER_H_
@@ -0,0 +1,47 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_TASK_H_
+#define _SHELL_TASK_H_
+
+#include <Arduino.h>
+
+// Background work run by ShellController::tick() between commands, see ShellController::addTask().
+// Tasks may send events with beginEvent()/endEvent() and may remove themselves while running.
+class ShellTask
+{
+private:
+    friend class ShellController;
+    ShellTask *next_;
+    bool added_;
+
+public:
+    ShellTask()
+    {
+        next_ = 0;
+        added_ = false;
+    }
+    virtual void run() = 0; // called on every tick, keep it short
+};
+
+#endif //_SHELL_TASK_H_
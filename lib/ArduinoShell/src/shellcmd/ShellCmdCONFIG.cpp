@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdCONFIG.h"
+
+IMPLEMENT_COMMAND_HANDLER(CONFIG, request, response)
+{
+    uint8_t op, key;
+    if (request.readEnum(&op, PSTR("GET|SET|LIST")) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    PGM_P keys = Config.keys();
+    if (!keys)
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    if (op == 2) // list
+    {
+        bool first = true;
+        for (key = 0; key < Config.count(); key++)
+        {
+            if (!Config.isSet(key))
+                continue;
+            if (!first)
+                response.println();
+            first = false;
+            ArgumentReader::printEnum(response, key, keys);
+            response.write('=');
+            Config.print(key, response);
+        }
+        return 0;
+    }
+    if (request.readEnum(&key, keys) <= 0 || key >= Config.count())
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (op == 0)
+    {
+        Config.print(key, response); // empty if not set
+        return 0;
+    }
+    char *value;
+    request.readToEnd(&value);
+    if (strlen(value) > SHELL_CONFIG_VALUE_LEN)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (!Config.set(key, value))
+        return SHELL_RESPONSE_ERR_IO_ERROR; // region is full
+    return 0;
+}
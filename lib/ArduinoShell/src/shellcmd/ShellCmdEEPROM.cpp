@@ -22,8 +22,13 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "ShellCmdEEPROM.h"
+#include "ShellHexWriter.h"
+#include "ShellEepromQueue.h"
+#include "ShellCrc32.h"
 #include <EEPROM.h>
 
+#define EEREAD_BLOCK_LEN 16
+
 IMPLEMENT_COMMAND_HANDLER(EEREAD, request, response)
 {
     int16_t address;
@@ -35,15 +40,17 @@ IMPLEMENT_COMMAND_HANDLER(EEREAD, request, response)
     request.readInt(&count);
     if (count <= 0 || count > 1024)
         count = 1024;
+    ShellHexWriter hex(response);
+    uint8_t block[EEREAD_BLOCK_LEN];
     while (count)
     {
-        int value = EEPROM.read(address);
-        if (value < 16)
-            response.write('0');
-        response.print(value, HEX);
-        count--;
-        address++;
+        uint8_t n = count < EEREAD_BLOCK_LEN ? count : EEREAD_BLOCK_LEN;
+        shellEepromRead(address, block, n);
+        hex.write(block, n);
+        count -= n;
+        address += n;
     }
+    hex.flush();
     return 0;
 }
 
@@ -69,9 +76,84 @@ IMPLEMENT_COMMAND_HANDLER(EEWRITE, request, response)
             int8_t value = hexupcase2int(*(hexstr++));
             if (*hexstr)
                 value = (value << 4) | hexupcase2int(*(hexstr++));
-            EEPROM.write(address, value);
+            shellEepromWrite(address, value); // queued when SHELL_EEPROM_QUEUE_LEN > 0
             address++;
         }
     }
     return 0;
 }
+
+IMPLEMENT_COMMAND_HANDLER(EESYNC, request, response)
+{
+    shellEepromSync();
+    return 0;
+}
+
+static uint32_t eepromCrc(uint16_t address, uint16_t len)
+{
+    uint8_t block[EEREAD_BLOCK_LEN];
+    uint32_t crc = 0;
+    while (len)
+    {
+        uint8_t n = len < EEREAD_BLOCK_LEN ? len : EEREAD_BLOCK_LEN;
+        shellEepromRead(address, block, n);
+        crc = shellCrc32(crc, block, n);
+        len -= n;
+        address += n;
+    }
+    return crc;
+}
+
+IMPLEMENT_COMMAND_HANDLER(EECRC, request, response)
+{
+    int16_t address, len;
+    if (request.readInt(&address, 0) <= 0 || request.readInt(&len, 1) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if ((uint32_t)address + len > EEPROM.length())
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint32_t crc = eepromCrc(address, len);
+    ShellHexWriter hex(response);
+    for (int8_t shift = 24; shift >= 0; shift -= 8)
+        hex.write(crc >> shift);
+    return 0;
+}
+
+IMPLEMENT_COMMAND_HANDLER(EECMP, request, response)
+{
+    int16_t start, len;
+    if (request.readInt(&start, 0) <= 0 || request.readInt(&len, 1) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    // all blocks are checked against the EEPROM size before any is compared
+    uint16_t blocks = 0;
+    char *rest = request.peek();
+    for (char *c = rest; *c; c++)
+        if (*c != ' ' && (c == rest || c[-1] == ' '))
+            blocks++;
+    if ((uint32_t)start + (uint32_t)len * blocks > EEPROM.length())
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint16_t address = start;
+    char *hexstr;
+    bool first = true;
+    while (request.readString(&hexstr, true))
+    {
+        uint32_t expected = 0;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            char c = hexstr[i];
+            if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F')))
+                return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+            expected = (expected << 4) | hexupcase2int(c);
+        }
+        if (hexstr[8])
+            return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+        if (eepromCrc(address, len) != expected) // only differing blocks are reported
+        {
+            if (!first)
+                response.write(' ');
+            response.print(address);
+            first = false;
+        }
+        address += len;
+    }
+    return 0;
+}
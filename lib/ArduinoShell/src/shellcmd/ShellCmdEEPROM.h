@@ -27,5 +27,8 @@ SOFTWARE.
 
 DECLARE_COMMAND_HANDLER(EEREAD, "Reads bytes from EEPROM. <addr> <count>");
 DECLARE_COMMAND_HANDLER(EEWRITE, "Writes bytes to EEPROM. <addr> <hexbytes>");
+DECLARE_COMMAND_HANDLER(EECRC, "Calculates CRC32 of EEPROM bytes. <addr> <len>");
+DECLARE_COMMAND_HANDLER(EECMP, "Lists EEPROM blocks not matching the CRC32s. <addr> <blocklen> <crc>...");
+DECLARE_COMMAND_HANDLER(EESYNC, "Waits for pending EEPROM writes.");
 
 #endif //_SHELL_CMD_EEPROM_H_
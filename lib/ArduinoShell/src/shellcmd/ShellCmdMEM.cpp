@@ -0,0 +1,233 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdMEM.h"
+#include "ShellHexWriter.h"
+
+// flash addresses are wider than data pointers on AVR
+#if __SIZEOF_POINTER__ > 4
+typedef uintptr_t mem_addr_t;
+#else
+typedef uint32_t mem_addr_t;
+#endif
+
+static mem_addr_t lastAddress(bool flash)
+{
+#if defined(FLASHEND)
+    if (flash)
+        return FLASHEND;
+#endif
+    return (uintptr_t)-1;
+}
+
+// rejects ranges not fitting the address space instead of wrapping them
+static bool parseAddress(const char *str, mem_addr_t len, bool flash, mem_addr_t *addr)
+{
+    long value;
+    if (!ArgumentReader::atol(str, &value) || value < 0)
+        return false;
+    *addr = value;
+    mem_addr_t last = lastAddress(flash);
+    return *addr <= last && last - *addr >= len - 1;
+}
+
+static uint8_t readFlash(mem_addr_t addr)
+{
+#if defined(__AVR__) && defined(RAMPZ)
+    return pgm_read_byte_far(addr);
+#else
+    return pgm_read_byte((const uint8_t *)(uintptr_t)addr);
+#endif
+}
+
+static uint32_t readMemory(mem_addr_t addr, uint8_t width, bool flash)
+{
+    uint32_t value = 0;
+    if (flash)
+    {
+        for (uint8_t i = 0; i < width; i++)
+            value |= (uint32_t)readFlash(addr + i) << (8 * i);
+        return value;
+    }
+    uintptr_t ptr = addr; // range is checked by parseAddress
+#if defined(__AVR__)
+    for (uint8_t i = 0; i < width; i++) // low byte first latches the high byte of 16 bit registers
+        value |= (uint32_t)*(volatile uint8_t *)(ptr + i) << (8 * i);
+#else
+    if (width == 1)
+        value = *(volatile uint8_t *)ptr;
+    else if (width == 2)
+        value = *(volatile uint16_t *)ptr;
+    else
+        value = *(volatile uint32_t *)ptr; // peripheral registers may not allow narrower access
+#endif
+    return value;
+}
+
+static void writeMemory(uintptr_t addr, uint8_t width, uint32_t value)
+{
+#if defined(__AVR__)
+    for (int8_t i = width - 1; i >= 0; i--) // high byte first goes to the temporary register of 16 bit registers
+        *(volatile uint8_t *)(addr + i) = value >> (8 * i);
+#else
+    if (width == 1)
+        *(volatile uint8_t *)addr = value;
+    else if (width == 2)
+        *(volatile uint16_t *)addr = value;
+    else
+        *(volatile uint32_t *)addr = value;
+#endif
+}
+
+static bool fits(long value, uint8_t width)
+{
+    if (width == 4)
+        return (uint32_t)value == (unsigned long)value;
+    return ((unsigned long)value >> (8 * width)) == 0;
+}
+
+static bool parseValue(const char *str, uint8_t width, uint32_t *value)
+{
+    long L;
+    if (!ArgumentReader::atol(str, &L) || !fits(L, width))
+        return false;
+    *value = L;
+    return true;
+}
+
+// reads options and the address, returns false on bad arguments
+static bool readAccess(ArgumentReader &request, mem_addr_t *addr, uint8_t *width, bool *flash)
+{
+    char *arg;
+    while (request.readString(&arg) > 0 && *arg == '-')
+    {
+        uint8_t w;
+        if (flash && strcasecmp_P(arg, PSTR("-F")) == 0)
+            *flash = true;
+        else if (strcasecmp_P(arg, PSTR("-W")) != 0 || request.readEnum(&w, PSTR("8|16|32")) <= 0)
+            return false;
+        else
+            *width = 1 << w;
+    }
+    if (!parseAddress(arg, *width, flash && *flash, addr))
+        return false;
+    return (flash && *flash) || *addr % *width == 0; // unaligned access faults on some cores
+}
+
+IMPLEMENT_COMMAND_HANDLER(PEEK, request, response)
+{
+    mem_addr_t addr;
+    uint8_t width = 1;
+    bool flash = false;
+    if (!readAccess(request, &addr, &width, &flash))
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint32_t value = readMemory(addr, width, flash);
+    ShellHexWriter hex(response);
+    for (int8_t i = width - 1; i >= 0; i--)
+        hex.write(value >> (8 * i));
+    return 0;
+}
+
+IMPLEMENT_COMMAND_HANDLER(POKE, request, response)
+{
+    mem_addr_t addr;
+    uint8_t width = 1;
+    char *str;
+    if (!readAccess(request, &addr, &width, 0) || request.readString(&str) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint32_t all = width < 4 ? (1UL << (8 * width)) - 1 : 0xffffffff;
+    uint32_t value, mask = all;
+    if (!parseValue(str, width, &value))
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (request.readString(&str) > 0 && !parseValue(str, width, &mask))
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (mask == all)
+    {
+        writeMemory(addr, width, value);
+        return 0;
+    }
+    // read-modify-write, interrupt handlers may change the other bits
+#if defined(__AVR__)
+    uint8_t sreg = SREG;
+    cli();
+#else
+    noInterrupts();
+#endif
+    writeMemory(addr, width, (readMemory(addr, width, false) & ~mask) | (value & mask));
+#if defined(__AVR__)
+    SREG = sreg;
+#else
+    interrupts();
+#endif
+    return 0;
+}
+
+IMPLEMENT_COMMAND_HANDLER(MEMDUMP, request, response)
+{
+    bool flash = false, binary = false;
+    char *arg;
+    while (request.readString(&arg) > 0 && *arg == '-')
+    {
+        if (strcasecmp_P(arg, PSTR("-F")) == 0)
+            flash = true;
+        else if (strcasecmp_P(arg, PSTR("-B")) == 0)
+            binary = true;
+        else
+            return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    }
+    char *addrstr = arg;
+    mem_addr_t addr;
+    int32_t len;
+    if (request.readLong(&len, 1, 0xffff) <= 0 || !parseAddress(addrstr, len, flash, &addr))
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint8_t row[SHELL_MEMDUMP_ROW_LEN];
+    if (binary)
+    {
+        response.print(len);
+        response.write(':');
+    }
+    ShellHexWriter hex(response);
+    while (len > 0)
+    {
+        uint8_t n = len < SHELL_MEMDUMP_ROW_LEN ? len : SHELL_MEMDUMP_ROW_LEN;
+        for (uint8_t i = 0; i < n; i++)
+            row[i] = flash ? readFlash(addr + i) : *(volatile uint8_t *)(uintptr_t)(addr + i);
+        if (binary)
+            response.write(row, n);
+        else
+        {
+            for (int8_t i = sizeof(mem_addr_t) - 1; i >= 0; i--)
+                hex.write(addr >> (8 * i));
+            hex.writeChar(' ');
+            hex.write(row, n);
+            if (len > n)
+            {
+                hex.writeChar('\r');
+                hex.writeChar('\n');
+            }
+        }
+        addr += n;
+        len -= n;
+    }
+    return 0;
+}
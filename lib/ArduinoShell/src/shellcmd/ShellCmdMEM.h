@@ -0,0 +1,42 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CMD_MEM_H_
+#define _SHELL_CMD_MEM_H_
+#include <ShellCommon.h>
+
+// Bytes per MEMDUMP hex line
+#if !defined(SHELL_MEMDUMP_ROW_LEN)
+#define SHELL_MEMDUMP_ROW_LEN 16
+#endif
+
+// Raw access to the data address space, registers and IO included on AVR, -f reads flash instead.
+// Accesses are 8, 16 or 32 bits wide and aligned, multi byte values are little endian and printed as hex.
+// On AVR bytes are read low first and written high first, as 16 bit timer registers require.
+// Reading some IO registers has side effects, e.g. it clears flags or consumes received bytes.
+DECLARE_COMMAND_HANDLER(PEEK, "Reads memory. [-f] [-w 8|16|32] <addr>");
+DECLARE_COMMAND_HANDLER(POKE, "Writes memory, only mask bits when given. [-w 8|16|32] <addr> <value> [<mask>]");
+// Hex is printed in lines of "<addr> <bytes>", binary (-b) is "<len>:" followed by the raw bytes.
+DECLARE_COMMAND_HANDLER(MEMDUMP, "Dumps memory. [-f] [-b] <addr> <len>");
+
+#endif //_SHELL_CMD_MEM_H_
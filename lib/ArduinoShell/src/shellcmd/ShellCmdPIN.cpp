@@ -23,43 +23,213 @@ SOFTWARE.
 */
 #include "ShellCmdPIN.h"
 
-IMPLEMENT_COMMAND_HANDLER(PIN, request, response)
+#define PIN_LIST_LEN 32
+#define APIN_MAX_SAMPLES 64
+#if defined(__AVR__)
+#define PORT_ID_COUNT 13 // PA..PL are 1..12, see pins_arduino.h
+#endif
+
+// parses a comma separated pin list, returns the number of pins or -1
+static int8_t parsePins(char *list, uint8_t *pins)
 {
+    ArgumentReader reader(',');
+    reader.begin((byte *)list);
+    int8_t count = 0;
     int16_t pin;
-    if (!request.readInt(&pin))
+    int8_t ret;
+    while ((ret = reader.readInt(&pin, 0, 255)) > 0)
+    {
+        if (count == PIN_LIST_LEN)
+            return -1;
+        pins[count++] = pin;
+    }
+    return ret < 0 ? -1 : count;
+}
+
+static void printPins(Print &response, uint8_t *pins, int8_t count)
+{
+    for (int8_t i = 0; i < count; i++)
+    {
+        if (i)
+            response.write(',');
+        response.print(pins[i]);
+    }
+}
+
+IMPLEMENT_COMMAND_HANDLER(PIN, request, response)
+{
+    uint8_t pins[PIN_LIST_LEN];
+    char *list;
+    request.readString(&list);
+    int8_t count = parsePins(list, pins);
+    if (count <= 0)
         return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
     uint8_t value;
     PGM_P options = PSTR("LOW|HIGH|INPUT|OUTPUT|PULLUP");
     int8_t ret = request.readEnum(&value, options);
     if (ret < 0)
         return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
-    if (ret)
+#if defined(__AVR__)
+    // pins are grouped by port, each port is read or changed with a single register access, all ports at once
+    uint8_t masks[PORT_ID_COUNT] = {0};
+    for (int8_t i = 0; i < count; i++)
     {
-        if (value < 2) // low,high
-            digitalWrite(pin, value);
-        else // input,output,pullup
-            pinMode(pin, value - 2);
+        uint8_t port = pins[i] < NUM_DIGITAL_PINS ? digitalPinToPort(pins[i]) : NOT_A_PIN;
+        if (port == NOT_A_PIN || port >= PORT_ID_COUNT)
+            return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+        masks[port] |= digitalPinToBitMask(pins[i]);
     }
-    else
-        value = digitalRead(pin);
-    response.print(pin);
+#endif
+    printPins(response, pins, count);
     response.write(' ');
-    ArgumentReader::printEnum(response, value, options);
+    if (ret)
+    {
+#if defined(__AVR__)
+        if (count > 1) // a single pin goes through digitalWrite, which also turns PWM off
+        {
+            uint8_t sreg = SREG;
+            cli();
+            for (uint8_t port = 1; port < PORT_ID_COUNT; port++)
+            {
+                uint8_t mask = masks[port];
+                if (!mask)
+                    continue;
+                volatile uint8_t *out = portOutputRegister(port);
+                volatile uint8_t *ddr = portModeRegister(port);
+                if (value == 3) // output
+                    *ddr |= mask;
+                else if (value > 1) // input, pullup
+                    *ddr &= ~mask;
+                if (value == 1 || value == 4) // high, pullup
+                    *out |= mask;
+                else if (value != 3)
+                    *out &= ~mask;
+            }
+            SREG = sreg;
+        }
+        else
+#endif
+            for (int8_t i = 0; i < count; i++)
+            {
+                if (value < 2) // low,high
+                    digitalWrite(pins[i], value);
+                else // input,output,pullup
+                    pinMode(pins[i], value - 2);
+            }
+        ArgumentReader::printEnum(response, value, options);
+        return 0;
+    }
+#if defined(__AVR__)
+    // input registers are sampled together
+    uint8_t sreg = SREG;
+    cli();
+    for (uint8_t port = 1; port < PORT_ID_COUNT; port++)
+        if (masks[port])
+            masks[port] &= *portInputRegister(port);
+    SREG = sreg;
+#endif
+    for (int8_t i = 0; i < count; i++)
+    {
+#if defined(__AVR__)
+        value = (masks[digitalPinToPort(pins[i])] & digitalPinToBitMask(pins[i])) ? HIGH : LOW;
+#else
+        value = digitalRead(pins[i]);
+#endif
+        if (i)
+            response.write(',');
+        ArgumentReader::printEnum(response, value, options);
+    }
     return 0;
 }
 
+IMPLEMENT_COMMAND_HANDLER(PORT, request, response)
+{
+#if defined(__AVR__)
+    char *name;
+    if (request.readString(&name, true) != 1 || *name < 'A' || *name > 'L')
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint8_t port = *name - 'A' + 1;
+    uint8_t pin = 0;
+    while (pin < NUM_DIGITAL_PINS && digitalPinToPort(pin) != port) // port tables are as long as the board needs
+        pin++;
+    if (pin == NUM_DIGITAL_PINS)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint8_t reg = 0;
+    PGM_P options = PSTR("PIN|OUT|DDR");
+    if (request.readEnum(&reg, options) < 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    volatile uint8_t *r = reg == 0 ? portInputRegister(port) : (reg == 1 ? portOutputRegister(port) : portModeRegister(port));
+    int16_t value, mask = 0xff;
+    int8_t ret = request.readInt(&value, 0, 0xff);
+    if (ret < 0 || request.readInt(&mask, 0, 0xff) < 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (ret)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        if (reg == 0)
+            *r = value & mask; // writing 1 to PINx toggles the pin
+        else
+            *r = (*r & ~mask) | (value & mask);
+        SREG = sreg;
+    }
+    value = *r;
+    response.print(F("0x"));
+    if (value < 16)
+        response.write('0');
+    response.print(value, HEX);
+    return 0;
+#else
+    return SHELL_RESPONSE_ERR_ILLEGAL_OPERATION;
+#endif
+}
+
 IMPLEMENT_COMMAND_HANDLER(APIN, request, response)
 {
-    int16_t pin;
-    if (!request.readInt(&pin))
+    bool fast = false;
+    int16_t samples = 1;
+    char *arg;
+    while (request.readString(&arg) > 0 && *arg == '-')
+    {
+        if (strcasecmp_P(arg, PSTR("-F")) == 0)
+            fast = true;
+        else if (strcasecmp_P(arg, PSTR("-N")) != 0 || request.readInt(&samples, 1, APIN_MAX_SAMPLES) <= 0)
+            return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    }
+    uint8_t pins[PIN_LIST_LEN];
+    int8_t count = parsePins(arg, pins);
+    if (count <= 0)
         return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
-    int16_t value;
-    if (!request.readInt(&value))
-        value = analogRead(pin);
-    else
-        analogWrite(pin, value);
-    response.print(pin);
+    printPins(response, pins, count);
     response.write(' ');
-    response.print(value);
+    int16_t value;
+    if (request.readInt(&value))
+    {
+        for (int8_t i = 0; i < count; i++)
+            analogWrite(pins[i], value);
+        response.print(value);
+        return 0;
+    }
+    uint16_t sums[PIN_LIST_LEN] = {0}; // 10 bit samples, APIN_MAX_SAMPLES of them fit
+#if defined(__AVR__) && defined(ADCSRA)
+    uint8_t adcsra = ADCSRA;
+    if (fast) // ADC clock is F_CPU/16 instead of F_CPU/128, 1 MHz at 16 MHz, costs about a bit of accuracy
+        ADCSRA = (adcsra & ~0x07) | 0x04;
+#endif
+    // channels are interleaved so every round is a near simultaneous snapshot
+    for (int16_t n = 0; n < samples; n++)
+        for (int8_t i = 0; i < count; i++)
+            sums[i] += analogRead(pins[i]);
+#if defined(__AVR__) && defined(ADCSRA)
+    ADCSRA = adcsra;
+#else
+    (void)fast;
+#endif
+    for (int8_t i = 0; i < count; i++)
+    {
+        if (i)
+            response.write(',');
+        response.print((sums[i] + samples / 2) / samples);
+    }
     return 0;
 }
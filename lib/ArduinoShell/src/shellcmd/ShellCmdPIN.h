@@ -25,7 +25,11 @@ SOFTWARE.
 #define _SHELL_CMD_PIN_H_
 #include <ShellCommon.h>
 
-DECLARE_COMMAND_HANDLER(PIN, "Performs digital R/W operation or configures a pin. <pin> [LOW|HIGH|INPUT|OUTPUT|PULLUP]");
-DECLARE_COMMAND_HANDLER(APIN, "Performs R/W on analog pin. <pin> [<value>]");
+// pins are comma separated, on AVR a list is read or changed at once per port
+DECLARE_COMMAND_HANDLER(PIN, "Performs digital R/W operation or configures pins. <pin>[,<pin>...] [LOW|HIGH|INPUT|OUTPUT|PULLUP]");
+// AVR only, writes are masked and atomic, writing to PIN toggles the masked bits
+DECLARE_COMMAND_HANDLER(PORT, "Reads or writes a port register. <port> [PIN|OUT|DDR] [<value> [<mask>]]");
+// -n averages up to 64 samples per pin, -f uses a faster ADC clock on AVR
+DECLARE_COMMAND_HANDLER(APIN, "Performs R/W on analog pins. [-f] [-n <samples>] <pin>[,<pin>...] [<value>]");
 
 #endif //_SHELL_CMD_PIN_H_
@@ -0,0 +1,209 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdSAMPLE.h"
+
+#if SHELL_TASKS
+#include <ShellCore.h>
+#include "ShellHexWriter.h"
+
+#define SAMPLE_ESCAPE 0xff
+
+class ShellSampler : public ShellTask
+{
+private:
+    Stream *endpoint_;
+    uint8_t pins_[SHELL_SAMPLE_MAX_CHANNELS];
+    uint8_t channels_;
+    bool sampling_;
+    uint32_t period_us_;
+    uint32_t next_us_;
+    uint16_t rounds_;  // 0 runs until stopped
+    uint32_t taken_;   // rounds sampled, continuous runs outlast 16 bits
+    uint32_t sent_;    // rounds sent
+    uint32_t late_;
+    uint16_t buffer_[SHELL_SAMPLE_BUFFER_LEN];
+    uint8_t head_;     // next sample
+    uint8_t count_;    // buffered samples
+    bool overrun_;
+    void sendBlock_(uint8_t samples);
+    void sendEnd_();
+
+public:
+    bool running() { return endpoint_ != 0; }
+    void begin(Stream *endpoint, uint8_t *pins, uint8_t channels, uint32_t period_us, uint16_t rounds);
+    void stop() { sampling_ = false; }
+    virtual void run();
+};
+
+static ShellSampler sampler_;
+
+void ShellSampler::begin(Stream *endpoint, uint8_t *pins, uint8_t channels, uint32_t period_us, uint16_t rounds)
+{
+    endpoint_ = endpoint;
+    memcpy(pins_, pins, channels);
+    channels_ = channels;
+    period_us_ = period_us;
+    rounds_ = rounds;
+    taken_ = sent_ = late_ = 0;
+    head_ = count_ = 0;
+    overrun_ = false;
+    sampling_ = true;
+    next_us_ = micros();
+    Shell.addTask(*this);
+}
+
+void ShellSampler::sendBlock_(uint8_t samples)
+{
+    uint16_t prev[SHELL_SAMPLE_MAX_CHANNELS] = {0};
+    uint8_t tail = (head_ + SHELL_SAMPLE_BUFFER_LEN - count_) % SHELL_SAMPLE_BUFFER_LEN;
+    Shell.print(F("SMP "));
+    Shell.print(sent_);
+    Shell.write(' ');
+    ShellHexWriter hex(Shell);
+    for (uint8_t i = 0, ch = 0; i < samples; i++)
+    {
+        uint16_t value = buffer_[tail];
+        int16_t delta = value - prev[ch];
+        uint16_t zigzag = delta >= 0 ? (uint16_t)delta << 1 : ((uint16_t)(-delta) << 1) - 1;
+        if (zigzag < SAMPLE_ESCAPE)
+            hex.write(zigzag);
+        else
+        {
+            hex.write(SAMPLE_ESCAPE);
+            hex.writeDigit(value >> 8);
+            hex.write(value & 0xff);
+        }
+        prev[ch] = value;
+        if (++ch == channels_)
+            ch = 0;
+        if (++tail == SHELL_SAMPLE_BUFFER_LEN)
+            tail = 0;
+    }
+    hex.flush();
+    count_ -= samples;
+    sent_ += samples / channels_;
+}
+
+void ShellSampler::sendEnd_()
+{
+    if (overrun_)
+    {
+        Shell.print(F("SMP OVERRUN "));
+        Shell.print(taken_);
+        return;
+    }
+    Shell.print(F("SMP END "));
+    Shell.print(taken_);
+    Shell.write(' ');
+    Shell.print(late_);
+}
+
+void ShellSampler::run()
+{
+    uint32_t now = micros();
+    while (sampling_ && (int32_t)(now - next_us_) >= 0)
+    {
+        if (count_ + channels_ > SHELL_SAMPLE_BUFFER_LEN)
+        {
+            overrun_ = true;
+            sampling_ = false;
+            break;
+        }
+        if (now - next_us_ >= period_us_)
+            late_++;
+        for (uint8_t ch = 0; ch < channels_; ch++)
+        {
+            buffer_[head_] = analogRead(pins_[ch]);
+            if (++head_ == SHELL_SAMPLE_BUFFER_LEN)
+                head_ = 0;
+        }
+        count_ += channels_;
+        next_us_ += period_us_;
+        taken_++; // still counted when continuous, for SMP END
+        if (rounds_ && taken_ == rounds_)
+            sampling_ = false;
+    }
+    uint8_t block = (SHELL_SAMPLE_BLOCK_LEN / channels_) * channels_;
+    if (!block)
+        block = channels_;
+    if (count_ < block && sampling_)
+        return;
+    // one event per tick
+    if (!Shell.beginEvent(*endpoint_))
+    {
+        if (!sampling_) // endpoint was removed or is busy with a transfer, retried until sampling ends
+        {
+            endpoint_ = 0;
+            Shell.removeTask(*this);
+        }
+        return;
+    }
+    if (count_)
+        sendBlock_(count_ < block ? count_ : block);
+    else
+    {
+        sendEnd_();
+        endpoint_ = 0;
+        Shell.removeTask(*this);
+    }
+    Shell.endEvent();
+}
+
+IMPLEMENT_COMMAND_HANDLER(SAMPLE, request, response)
+{
+    char *arg;
+    request.readString(&arg);
+    if (strcasecmp_P(arg, PSTR("STOP")) == 0)
+    {
+        sampler_.stop();
+        return 0;
+    }
+    if (sampler_.running())
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    Stream *endpoint = Shell.getRequestingEndpoint();
+    if (!endpoint)
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    uint8_t pins[SHELL_SAMPLE_MAX_CHANNELS];
+    ArgumentReader list(',');
+    list.begin((byte *)arg);
+    uint8_t channels = 0;
+    int16_t pin, rate, rounds;
+    int8_t ret;
+    while ((ret = list.readInt(&pin, 0, 255)) > 0)
+    {
+        if (channels == SHELL_SAMPLE_MAX_CHANNELS)
+            return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+        pins[channels++] = pin;
+    }
+    if (ret < 0 || !channels)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (request.readInt(&rate, 1, 10000) <= 0 || request.readInt(&rounds, 0) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint32_t period_us = 1000000UL / rate;
+    sampler_.begin(endpoint, pins, channels, period_us, rounds);
+    response.print(period_us); // actual period
+    return 0;
+}
+
+#endif
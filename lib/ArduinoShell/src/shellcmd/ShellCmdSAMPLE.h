@@ -0,0 +1,54 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CMD_SAMPLE_H_
+#define _SHELL_CMD_SAMPLE_H_
+#include <ShellCommon.h>
+
+#if SHELL_TASKS
+
+// Number of samples buffered between sampling and sending
+#if !defined(SHELL_SAMPLE_BUFFER_LEN)
+#define SHELL_SAMPLE_BUFFER_LEN 64
+#endif
+
+// Samples per event, rounded down to whole rounds of all channels
+#if !defined(SHELL_SAMPLE_BLOCK_LEN)
+#define SHELL_SAMPLE_BLOCK_LEN 16
+#endif
+
+#define SHELL_SAMPLE_MAX_CHANNELS 8
+
+// Samples analog pins on a micros() schedule from tick(), so other commands are served meanwhile.
+// Timing jitter is bounded by the tick latency, rounds taken a whole period late are counted.
+// Data is sent to the requesting endpoint as events:
+//   SMP <round> <samples>        samples of consecutive rounds starting from round, channels interleaved
+//   SMP END <rounds> <late>      capture completed or stopped
+//   SMP OVERRUN <round>          buffer was full, sending could not keep up, capture is stopped
+// Each sample is the difference from the previous sample of the same channel in the event (0 for the first),
+// zigzag encoded (0,-1,1,-2.. -> 0,1,2,3..) as 2 hex digits, or FF followed by the absolute value in 3 hex digits.
+DECLARE_COMMAND_HANDLER(SAMPLE, "Samples analog pins at a fixed rate. <pin>[,<pin>...] <rate_hz> <count> | STOP");
+
+#endif
+
+#endif //_SHELL_CMD_SAMPLE_H_
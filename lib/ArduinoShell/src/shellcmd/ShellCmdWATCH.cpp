@@ -0,0 +1,320 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdWATCH.h"
+
+#if SHELL_WATCH
+#include <ShellCore.h>
+
+#define WATCH_LEVEL 1
+#define WATCH_DROPPED 2 // edges were dropped after this one
+
+// written by the interrupt handler
+static volatile uint32_t watch_times_[SHELL_WATCH_BUFFER_LEN];
+static volatile uint8_t watch_levels_[SHELL_WATCH_BUFFER_LEN];
+static volatile uint8_t watch_head_;
+static volatile uint16_t watch_lost_;
+// written by the task
+static volatile uint8_t watch_tail_;
+static uint8_t watch_pin_;
+static uint8_t watch_mode_;
+#if defined(__AVR__)
+static volatile uint8_t *watch_port_;
+static uint8_t watch_mask_;
+#endif
+
+static void watchEdge_()
+{
+    uint8_t head = watch_head_;
+    uint8_t next = head + 1 == SHELL_WATCH_BUFFER_LEN ? 0 : head + 1;
+    if (next == watch_tail_)
+    {
+        watch_levels_[head ? head - 1 : SHELL_WATCH_BUFFER_LEN - 1] |= WATCH_DROPPED;
+        watch_lost_++;
+        return;
+    }
+    watch_times_[head] = micros();
+    if (watch_mode_ == CHANGE)
+#if defined(__AVR__)
+        watch_levels_[head] = (*watch_port_ & watch_mask_) != 0;
+#else
+        watch_levels_[head] = digitalRead(watch_pin_);
+#endif
+    else
+        watch_levels_[head] = watch_mode_ == RISING;
+    watch_head_ = next;
+}
+
+struct WatchWidth
+{
+    uint16_t count;
+    uint32_t min, max, sum;
+    void reset()
+    {
+        count = 0;
+        min = 0xffffffff;
+        max = sum = 0;
+    }
+    void add(uint32_t us)
+    {
+        if (count == 0xffff || sum + us < sum)
+            return; // saturated, reset with STAT -r
+        count++;
+        sum += us;
+        if (us < min)
+            min = us;
+        if (us > max)
+            max = us;
+    }
+    uint32_t avg() { return count ? sum / count : 0; }
+    void print(Print &out, const __FlashStringHelper *name)
+    {
+        out.print(name);
+        out.write(' ');
+        out.print(count);
+        out.write(' ');
+        out.print(count ? min : 0);
+        out.write(' ');
+        out.print(avg());
+        out.write(' ');
+        out.print(max);
+        out.println();
+    }
+};
+
+class ShellWatcher : public ShellTask
+{
+private:
+    Stream *endpoint_;
+    bool watching_;
+    uint32_t last_us_;        // previous edge
+    uint8_t last_level_;
+    uint32_t last_same_us_[2]; // previous edge to each level, for periods
+    bool seen_[2];
+    uint32_t edges_;
+    uint16_t lost_;          // reported
+    bool dropped_;           // LOST is sent next
+    bool after_drop_;        // edges were lost before the next edge, its delta spans them
+    uint32_t last_send_ms_;
+    WatchWidth widths_[2]; // low, high
+    WatchWidth periods_;
+    void sendBlock_(uint8_t count);
+
+public:
+    bool running() { return endpoint_ != 0; }
+    uint8_t begin(Stream *endpoint, uint8_t pin, uint8_t mode);
+    void stop();
+    void resetStats();
+    void printStats(Print &out);
+    virtual void run();
+};
+
+static ShellWatcher watcher_;
+
+uint8_t ShellWatcher::begin(Stream *endpoint, uint8_t pin, uint8_t mode)
+{
+    endpoint_ = endpoint;
+    watch_pin_ = pin;
+    watch_mode_ = mode;
+#if defined(__AVR__)
+    watch_port_ = portInputRegister(digitalPinToPort(pin));
+    watch_mask_ = digitalPinToBitMask(pin);
+#endif
+    watch_head_ = watch_tail_ = 0;
+    watch_lost_ = 0;
+    lost_ = 0;
+    dropped_ = false;
+    after_drop_ = false;
+    edges_ = 0;
+    seen_[0] = seen_[1] = false;
+    resetStats();
+    watching_ = true;
+    last_send_ms_ = millis();
+    last_us_ = micros();
+    last_level_ = digitalRead(pin);
+    attachInterrupt(digitalPinToInterrupt(pin), watchEdge_, mode);
+    Shell.addTask(*this);
+    return last_level_;
+}
+
+void ShellWatcher::stop()
+{
+    if (!watching_)
+        return;
+    detachInterrupt(digitalPinToInterrupt(watch_pin_));
+    watching_ = false;
+}
+
+void ShellWatcher::resetStats()
+{
+    widths_[0].reset();
+    widths_[1].reset();
+    periods_.reset();
+}
+
+void ShellWatcher::printStats(Print &out)
+{
+    noInterrupts();
+    uint16_t lost = watch_lost_;
+    interrupts();
+    out.print(F("EDGES "));
+    out.print(edges_);
+    out.write(' ');
+    out.print(lost);
+    out.println();
+    widths_[1].print(out, F("HIGH"));
+    widths_[0].print(out, F("LOW"));
+    periods_.print(out, F("PERIOD"));
+    out.print(F("FREQ "));
+    uint32_t period = periods_.avg();
+    uint32_t mhz = period ? 1000000000UL / period : 0;
+    out.print(mhz / 1000);
+    out.write('.');
+    mhz %= 1000;
+    if (mhz < 100)
+        out.write('0');
+    if (mhz < 10)
+        out.write('0');
+    out.print(mhz);
+}
+
+void ShellWatcher::sendBlock_(uint8_t count)
+{
+    uint8_t tail = watch_tail_;
+    Shell.print(F("EDG "));
+    Shell.print(edges_);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint32_t time = watch_times_[tail];
+        uint8_t level = watch_levels_[tail];
+        dropped_ = level & WATCH_DROPPED;
+        level &= WATCH_LEVEL;
+        uint32_t delta = time - last_us_;
+        if (after_drop_) // not a width or period, statistics restart from this edge
+            seen_[0] = seen_[1] = false;
+        else if (edges_ > 0 && level != last_level_)
+            widths_[last_level_].add(delta);
+        if (seen_[level])
+            periods_.add(time - last_same_us_[level]);
+        after_drop_ = dropped_;
+        seen_[level] = true;
+        last_same_us_[level] = time;
+        last_us_ = time;
+        last_level_ = level;
+        edges_++;
+        Shell.write(' ');
+        Shell.write(level ? 'H' : 'L');
+        Shell.print(delta);
+        if (++tail == SHELL_WATCH_BUFFER_LEN)
+            tail = 0;
+        if (dropped_)
+            break;
+    }
+    watch_tail_ = tail; // frees the slots for the interrupt handler
+    last_send_ms_ = millis();
+}
+
+void ShellWatcher::run()
+{
+    uint8_t head = watch_head_;
+    uint8_t count = (head + SHELL_WATCH_BUFFER_LEN - watch_tail_) % SHELL_WATCH_BUFFER_LEN;
+    noInterrupts();
+    uint16_t lost = watch_lost_;
+    interrupts();
+    bool report = lost != lost_ && (dropped_ || !count); // the marker may be missed while its edge is sent
+    if (watching_ && !report && (!count || (count < SHELL_WATCH_BLOCK_LEN && millis() - last_send_ms_ < SHELL_WATCH_INTERVAL_MS)))
+        return;
+    // one event per tick
+    if (!Shell.beginEvent(*endpoint_))
+    {
+        if (!watching_) // endpoint was removed or is busy with a transfer, retried until watching ends
+        {
+            endpoint_ = 0;
+            Shell.removeTask(*this);
+        }
+        return;
+    }
+    if (report)
+    {
+        Shell.print(F("EDG LOST "));
+        Shell.print(lost);
+        lost_ = lost;
+        dropped_ = false;
+    }
+    else if (count)
+        sendBlock_(count < SHELL_WATCH_BLOCK_LEN ? count : SHELL_WATCH_BLOCK_LEN);
+    else
+    {
+        Shell.print(F("EDG END "));
+        Shell.print(edges_);
+        Shell.write(' ');
+        Shell.print(lost);
+        endpoint_ = 0;
+        Shell.removeTask(*this);
+    }
+    Shell.endEvent();
+}
+
+IMPLEMENT_COMMAND_HANDLER(WATCH, request, response)
+{
+    char *arg;
+    request.readString(&arg);
+    if (strcasecmp_P(arg, PSTR("STOP")) == 0)
+    {
+        watcher_.stop();
+        return 0;
+    }
+    if (strcasecmp_P(arg, PSTR("STAT")) == 0)
+    {
+        char *opt;
+        if (request.readString(&opt) > 0)
+        {
+            if (strcmp_P(opt, PSTR("-r")))
+                return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+            watcher_.resetStats();
+            return 0;
+        }
+        watcher_.printStats(response);
+        return 0;
+    }
+    ArgumentReader number;
+    number.begin((byte *)arg);
+    int16_t pin;
+    if (number.readInt(&pin, 0, 255) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (watcher_.running())
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    Stream *endpoint = Shell.getRequestingEndpoint();
+    if (!endpoint)
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    if (digitalPinToInterrupt(pin) == NOT_AN_INTERRUPT)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    uint8_t mode = 2;
+    if (request.readEnum(&mode, PSTR("RISING|FALLING|CHANGE")) < 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    static const uint8_t modes[] = {RISING, FALLING, CHANGE};
+    response.print(watcher_.begin(endpoint, pin, modes[mode]));
+    return 0;
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CMD_WATCH_H_
+#define _SHELL_CMD_WATCH_H_
+#include <ShellCommon.h>
+
+// Edge capture needs external interrupts
+#if SHELL_TASKS && defined(digitalPinToInterrupt)
+#define SHELL_WATCH 1
+
+// Number of edges buffered by the interrupt handler, one is kept free
+#if !defined(SHELL_WATCH_BUFFER_LEN)
+#define SHELL_WATCH_BUFFER_LEN 32
+#endif
+
+// Edges per event
+#if !defined(SHELL_WATCH_BLOCK_LEN)
+#define SHELL_WATCH_BLOCK_LEN 8
+#endif
+
+// Fewer edges are sent at most this often
+#if !defined(SHELL_WATCH_INTERVAL_MS)
+#define SHELL_WATCH_INTERVAL_MS 100
+#endif
+
+// Records edges of an interrupt pin with micros() timestamps, responds with the pin level.
+// Edges are sent to the requesting endpoint as events:
+//   EDG <edge> <edges>        consecutive edges starting from edge, each is H or L followed by
+//                             microseconds since the previous edge (since WATCH for the first one)
+//   EDG LOST <lost>           buffer was full and edges were dropped, the next delta includes them
+//   EDG END <edges> <lost>    watch stopped
+// STAT prints the edge counts, count/min/avg/max of high and low pulse widths in microseconds,
+// of the periods between edges in the same direction, and the frequency in Hz. -r resets them.
+DECLARE_COMMAND_HANDLER(WATCH, "Captures edges of an interrupt pin. <pin> [RISING|FALLING|CHANGE] | STOP | STAT [-r]");
+
+#endif
+
+#endif //_SHELL_CMD_WATCH_H_
@@ -0,0 +1,262 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellCmdXFER.h"
+
+#if SHELL_TRANSFER
+#include <ShellCore.h>
+#include "ShellEepromQueue.h"
+#include "ShellCrc32.h"
+#include <EEPROM.h>
+
+class XferTransfer : public ShellTransfer
+{
+private:
+    enum
+    {
+        RX_SOH,
+        RX_SEQ,
+        RX_LEN,
+        RX_DATA,
+        RX_CRC
+    };
+    bool put_;
+    uint16_t address_;
+    uint16_t len_;
+    uint16_t done_;    // acknowledged bytes
+    uint16_t sent_;    // GET: bytes sent, may go back on NAK or timeout
+    uint8_t rx_state_; // PUT: block receive state, GET: type of the reply being received
+    uint8_t rx_pos_;
+    uint8_t rx_seq_;
+    uint8_t rx_len_;
+    bool nak_sent_; // one NAK per error until a good block arrives
+    uint8_t retries_;
+    uint32_t last_ms_;
+    uint32_t rx_crc_;
+    uint8_t block_[SHELL_XFER_BLOCK_LEN];
+
+    uint8_t blockLen_(uint16_t offset)
+    {
+        uint16_t n = len_ - offset;
+        return n < SHELL_XFER_BLOCK_LEN ? n : SHELL_XFER_BLOCK_LEN;
+    }
+    static uint8_t seqOf_(uint16_t offset) { return (offset / SHELL_XFER_BLOCK_LEN) & 0xff; }
+    static void reply_(Stream &stream, uint8_t type, uint8_t seq)
+    {
+        stream.write(type);
+        stream.write(seq);
+        stream.flush();
+    }
+    uint32_t blockCrc_(uint8_t seq, uint8_t len)
+    {
+        uint8_t header[2] = {seq, len};
+        return shellCrc32(shellCrc32(0, header, 2), block_, len);
+    }
+    bool runPut_(Stream &stream);
+    bool runGet_(Stream &stream);
+    void receivedPut_(Stream &stream);
+
+public:
+    void begin(bool put, uint16_t address, uint16_t len)
+    {
+        put_ = put;
+        address_ = address;
+        len_ = len;
+        done_ = sent_ = 0;
+        rx_state_ = RX_SOH;
+        nak_sent_ = false;
+        retries_ = 0;
+        last_ms_ = millis();
+    }
+    virtual bool run(Stream &stream)
+    {
+        return put_ ? runPut_(stream) : runGet_(stream);
+    }
+};
+
+static XferTransfer xfer_;
+
+void XferTransfer::receivedPut_(Stream &stream)
+{
+    uint8_t expected = seqOf_(done_);
+    if (rx_crc_ != blockCrc_(rx_seq_, rx_len_))
+    {
+        if (!nak_sent_)
+            reply_(stream, SHELL_XFER_NAK, expected);
+        nak_sent_ = true;
+        return;
+    }
+    if (rx_seq_ == expected && rx_len_ == blockLen_(done_))
+    {
+        for (uint8_t i = 0; i < rx_len_; i++)
+            shellEepromWrite(address_ + done_ + i, block_[i]);
+        done_ += rx_len_;
+        nak_sent_ = false;
+        reply_(stream, SHELL_XFER_ACK, rx_seq_);
+    }
+    else if ((uint8_t)(expected - rx_seq_) <= SHELL_XFER_WINDOW) // resent after a lost ACK
+        reply_(stream, SHELL_XFER_ACK, expected - 1);
+    else if (!nak_sent_) // out of order, a block was lost
+    {
+        reply_(stream, SHELL_XFER_NAK, expected);
+        nak_sent_ = true;
+    }
+}
+
+bool XferTransfer::runPut_(Stream &stream)
+{
+    uint32_t now = millis();
+    while (stream.available() && done_ < len_)
+    {
+        uint8_t c = stream.read();
+        last_ms_ = now;
+        switch (rx_state_)
+        {
+        case RX_SOH:
+            if (c == SHELL_XFER_CAN)
+                return false;
+            if (c == SHELL_XFER_SOH)
+                rx_state_ = RX_SEQ;
+            break; // anything else is noise
+        case RX_SEQ:
+            rx_seq_ = c;
+            rx_state_ = RX_LEN;
+            break;
+        case RX_LEN:
+            rx_len_ = c;
+            rx_pos_ = 0;
+            rx_state_ = (c && c <= SHELL_XFER_BLOCK_LEN) ? RX_DATA : RX_SOH;
+            break;
+        case RX_DATA:
+            block_[rx_pos_++] = c;
+            if (rx_pos_ == rx_len_)
+            {
+                rx_pos_ = 0;
+                rx_crc_ = 0;
+                rx_state_ = RX_CRC;
+            }
+            break;
+        case RX_CRC:
+            rx_crc_ |= (uint32_t)c << (8 * rx_pos_);
+            if (++rx_pos_ == 4)
+            {
+                rx_state_ = RX_SOH;
+                receivedPut_(stream);
+            }
+            break;
+        }
+    }
+    if (done_ >= len_)
+        return false;
+    if (now - last_ms_ >= SHELL_XFER_TIMEOUT_MS * (uint32_t)SHELL_XFER_RETRIES)
+    {
+        stream.write(SHELL_XFER_CAN);
+        return false;
+    }
+    return true;
+}
+
+bool XferTransfer::runGet_(Stream &stream)
+{
+    uint32_t now = millis();
+    while (stream.available())
+    {
+        uint8_t c = stream.read();
+        if (rx_state_ == RX_SOH) // reply type
+        {
+            if (c == SHELL_XFER_CAN)
+                return false;
+            if (c == SHELL_XFER_ACK || c == SHELL_XFER_NAK)
+                rx_state_ = c;
+            continue;
+        }
+        uint8_t type = rx_state_;
+        rx_state_ = RX_SOH;
+        uint16_t outstanding = (sent_ - done_ + SHELL_XFER_BLOCK_LEN - 1) / SHELL_XFER_BLOCK_LEN;
+        uint8_t ahead = c - seqOf_(done_);
+        if (type == SHELL_XFER_ACK && ahead < outstanding)
+        {
+            done_ += (uint16_t)(ahead + 1) * SHELL_XFER_BLOCK_LEN;
+            if (done_ > sent_) // last block is shorter
+                done_ = sent_;
+            retries_ = 0;
+            last_ms_ = now;
+        }
+        else if (type == SHELL_XFER_NAK && ahead == 0)
+            sent_ = done_; // go back
+    }
+    if (done_ >= len_)
+        return false;
+    if (now - last_ms_ >= SHELL_XFER_TIMEOUT_MS)
+    {
+        if (++retries_ > SHELL_XFER_RETRIES)
+        {
+            stream.write(SHELL_XFER_CAN);
+            return false;
+        }
+        sent_ = done_;
+        last_ms_ = now;
+    }
+    if (sent_ < len_ && sent_ - done_ < (uint16_t)SHELL_XFER_WINDOW * SHELL_XFER_BLOCK_LEN)
+    {
+        // one block per tick
+        uint8_t seq = seqOf_(sent_);
+        uint8_t n = blockLen_(sent_);
+        shellEepromRead(address_ + sent_, block_, n);
+        uint32_t crc = blockCrc_(seq, n);
+        stream.write(SHELL_XFER_SOH);
+        stream.write(seq);
+        stream.write(n);
+        stream.write(block_, n);
+        for (uint8_t i = 0; i < 4; i++, crc >>= 8)
+            stream.write((uint8_t)crc);
+        stream.flush();
+        sent_ += n;
+    }
+    return true;
+}
+
+IMPLEMENT_COMMAND_HANDLER(XFER, request, response)
+{
+    uint8_t area, dir;
+    int16_t address, len;
+    if (request.readEnum(&area, PSTR("EE")) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (request.readEnum(&dir, PSTR("GET|PUT")) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (request.readInt(&address, 0) <= 0 || request.readInt(&len, 1) <= 0)
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if ((uint32_t)address + len > EEPROM.length()) // would wrap to the beginning
+        return SHELL_RESPONSE_ERR_BAD_ARGUMENT;
+    if (Shell.getTransferEndpoint()) // xfer_ is in use
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    xfer_.begin(dir == 1, address, len);
+    if (!Shell.startTransfer(&xfer_))
+        return SHELL_RESPONSE_ERR_ILLEGAL_STATE;
+    response.print(SHELL_XFER_BLOCK_LEN);
+    response.write(' ');
+    response.print(SHELL_XFER_WINDOW);
+    return 0;
+}
+
+#endif
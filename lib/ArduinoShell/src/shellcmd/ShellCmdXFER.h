@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CMD_XFER_H_
+#define _SHELL_CMD_XFER_H_
+#include <ShellCommon.h>
+
+#if SHELL_TRANSFER
+
+// Data bytes per block, max 255
+#if !defined(SHELL_XFER_BLOCK_LEN)
+#define SHELL_XFER_BLOCK_LEN 64
+#endif
+
+// Number of blocks sent without waiting for an acknowledgement
+#if !defined(SHELL_XFER_WINDOW)
+#define SHELL_XFER_WINDOW 4
+#endif
+
+// Transfer is cancelled if the peer is silent for this long, blocks are resent on every timeout
+#if !defined(SHELL_XFER_TIMEOUT_MS)
+#define SHELL_XFER_TIMEOUT_MS 1000
+#endif
+
+#if !defined(SHELL_XFER_RETRIES)
+#define SHELL_XFER_RETRIES 5
+#endif
+
+// Protocol, started by the response of the command which is "<blocklen> <window>":
+//   block:  SOH <seq> <len> <data> <crc32 of seq,len,data, little endian>
+//   reply:  ACK <seq> acknowledges all blocks up to seq, NAK <seq> requests resending from seq
+//   CAN cancels in both directions
+// seq is the block index modulo 256. PUT completes when the last block is acknowledged by the device,
+// GET completes when the host acknowledges the last block.
+#define SHELL_XFER_SOH 0x01
+#define SHELL_XFER_ACK 0x06
+#define SHELL_XFER_NAK 0x15
+#define SHELL_XFER_CAN 0x18
+
+DECLARE_COMMAND_HANDLER(XFER, "Transfers binary EEPROM images. EE GET|PUT <addr> <len>");
+
+#endif
+
+#endif //_SHELL_CMD_XFER_H_
@@ -0,0 +1,185 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellConfigStore.h"
+#include "ShellEepromQueue.h"
+
+#define CONFIG_LOG_START 2 // after signature
+#define CONFIG_END 0xff
+const uint8_t config_signature[2] = {'K', 'V'};
+
+ShellConfigStore::ShellConfigStore()
+{
+    keys_ = 0;
+    key_count_ = 0;
+    size_ = 0;
+    end_ = 0;
+}
+
+uint8_t ShellConfigStore::read_(uint16_t offset)
+{
+    uint8_t value;
+    shellEepromRead(address_ + offset, &value, 1); // sees queued writes
+    return value;
+}
+
+void ShellConfigStore::write_(uint16_t offset, uint8_t value)
+{
+    shellEepromWrite(address_ + offset, value);
+}
+
+bool ShellConfigStore::begin(PGM_P keys, uint16_t address, uint16_t size)
+{
+    keys_ = keys;
+    address_ = address;
+    size_ = size;
+    key_count_ = 1;
+    for (PGM_P p = keys; pgm_read_byte_near(p); p++)
+        if (pgm_read_byte_near(p) == '|')
+            key_count_++;
+    if (key_count_ > SHELL_CONFIG_MAX_KEYS)
+        key_count_ = SHELL_CONFIG_MAX_KEYS;
+    memset(offsets_, 0, sizeof(offsets_));
+    end_ = CONFIG_LOG_START;
+    if (read_(0) != config_signature[0] || read_(1) != config_signature[1])
+    {
+        write_(0, config_signature[0]);
+        write_(1, config_signature[1]);
+        write_(end_, CONFIG_END);
+        return false;
+    }
+    while (end_ + 2 <= size_)
+    {
+        uint8_t key = read_(end_);
+        if (key == CONFIG_END)
+            break;
+        uint8_t len = read_(end_ + 1);
+        if (len > SHELL_CONFIG_VALUE_LEN || end_ + 2 + len > size_)
+        {
+            write_(end_, CONFIG_END); // truncated at the first bad record
+            return false;
+        }
+        if (key < key_count_) // keys no longer in the list are skipped, compaction drops them
+            offsets_[key] = len ? end_ : 0;
+        end_ += 2 + len;
+    }
+    return true;
+}
+
+int16_t ShellConfigStore::get(uint8_t key, char *value, uint8_t size)
+{
+    if (!isSet(key) || !size)
+        return -1;
+    uint16_t offset = offsets_[key];
+    uint8_t len = read_(offset + 1);
+    if (len >= size)
+        len = size - 1;
+    shellEepromRead(address_ + offset + 2, (uint8_t *)value, len);
+    value[len] = 0;
+    return len;
+}
+
+bool ShellConfigStore::print(uint8_t key, Print &out)
+{
+    if (!isSet(key))
+        return false;
+    uint16_t offset = offsets_[key];
+    uint8_t len = read_(offset + 1);
+    for (uint8_t i = 0; i < len; i++)
+        out.write(read_(offset + 2 + i));
+    return true;
+}
+
+uint16_t ShellConfigStore::available()
+{
+    uint16_t used = CONFIG_LOG_START;
+    for (uint8_t k = 0; k < key_count_; k++)
+        if (offsets_[k])
+            used += 2 + read_(offsets_[k] + 1);
+    return size_ > used ? size_ - used : 0;
+}
+
+// moves live records to the beginning of the log, each record moves forward so it is copied in place
+void ShellConfigStore::compact_()
+{
+    uint16_t src = CONFIG_LOG_START;
+    uint16_t dst = CONFIG_LOG_START;
+    while (src < end_)
+    {
+        uint8_t key = read_(src);
+        uint8_t len = read_(src + 1);
+        if (key < key_count_ && offsets_[key] == src)
+        {
+            offsets_[key] = dst;
+            if (dst != src)
+                for (uint8_t i = 0; i < 2 + len; i++)
+                    write_(dst + i, read_(src + i));
+            dst += 2 + len;
+        }
+        src += 2 + len;
+    }
+    end_ = dst;
+    if (end_ < size_)
+        write_(end_, CONFIG_END);
+}
+
+bool ShellConfigStore::set(uint8_t key, const char *value)
+{
+    if (key >= key_count_)
+        return false;
+    size_t n = value ? strlen(value) : 0;
+    if (n > SHELL_CONFIG_VALUE_LEN)
+        return false;
+    uint8_t len = n;
+    if (!len && !isSet(key))
+        return true;
+    if (isSet(key) && read_(offsets_[key] + 1) == len)
+    {
+        uint8_t i = 0;
+        while (i < len && read_(offsets_[key] + 2 + i) == (uint8_t)value[i])
+            i++;
+        if (i == len)
+            return true; // unchanged, nothing is written
+    }
+    if (end_ + 2 + len > size_)
+    {
+        uint16_t old = isSet(key) ? 2 + read_(offsets_[key] + 1) : 0;
+        if (available() + old < 2 + len)
+            return false;
+        offsets_[key] = 0; // replaced, dropped by compaction
+        compact_();
+    }
+    // the key byte is written last so an interrupted append looks like the end of the log
+    uint16_t offset = end_;
+    if (offset + 2 + len < size_)
+        write_(offset + 2 + len, CONFIG_END);
+    write_(offset + 1, len);
+    for (uint8_t i = 0; i < len; i++)
+        write_(offset + 2 + i, value[i]);
+    write_(offset, key);
+    offsets_[key] = len ? offset : 0;
+    end_ = offset + 2 + len;
+    return true;
+}
+
+ShellConfigStore Config;
@@ -0,0 +1,75 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_CONFIG_STORE_H_
+#define _SHELL_CONFIG_STORE_H_
+#include <ShellCommon.h>
+
+// Maximum number of keys, each takes 2 bytes of RAM for the index
+#if !defined(SHELL_CONFIG_MAX_KEYS)
+#define SHELL_CONFIG_MAX_KEYS 16
+#endif
+
+// Maximum length of a value
+#if !defined(SHELL_CONFIG_VALUE_LEN)
+#define SHELL_CONFIG_VALUE_LEN 32
+#endif
+
+// Persistent key/value settings in an EEPROM region.
+// Keys are declared as a PROGMEM list like readEnum() options, e.g. PSTR("SSID|RATE|MODE"), and addressed by index.
+// The region is an append log of <key><len><value> records after a 2 byte signature, ended by 0xFF or the region end.
+// begin() scans it once and keeps the offset of the latest record of each key, so lookups do not search.
+// When the region is full the live records are compacted in place, which is not power loss safe.
+// Records are stored by key index, so new keys are appended to the list. Records of indexes beyond
+// the list are skipped by begin() and dropped by the next compaction.
+class ShellConfigStore
+{
+private:
+    PGM_P keys_;
+    uint8_t key_count_;
+    uint16_t address_;
+    uint16_t size_;
+    uint16_t end_;                            // offset of the end of the log
+    uint16_t offsets_[SHELL_CONFIG_MAX_KEYS]; // record offsets, 0 if not set
+    uint8_t read_(uint16_t offset);
+    void write_(uint16_t offset, uint8_t value);
+    void compact_();
+
+public:
+    ShellConfigStore();
+    // returns false if the region was not formatted or was corrupt, it is formatted then
+    bool begin(PGM_P keys, uint16_t address, uint16_t size);
+    PGM_P keys() { return keys_; }
+    uint8_t count() { return key_count_; }
+    bool isSet(uint8_t key) { return key < key_count_ && offsets_[key]; }
+    // copies the value with null termination, returns its length or -1 if it is not set
+    int16_t get(uint8_t key, char *value, uint8_t size);
+    bool print(uint8_t key, Print &out); // false if not set
+    // empty or null value removes the key, returns false if the value is too long or does not fit
+    bool set(uint8_t key, const char *value);
+    uint16_t available(); // free bytes after compaction
+};
+
+extern ShellConfigStore Config;
+
+#endif //_SHELL_CONFIG_STORE_H_
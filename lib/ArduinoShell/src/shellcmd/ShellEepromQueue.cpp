@@ -0,0 +1,252 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellEepromQueue.h"
+#include <EEPROM.h>
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif
+
+static void readBlock_(uint16_t address, uint8_t *data, uint8_t count)
+{
+#if defined(__AVR__)
+    eeprom_read_block(data, (const void *)address, count);
+#else
+    for (uint8_t i = 0; i < count; i++)
+        data[i] = EEPROM.read(address + i);
+#endif
+}
+
+#if SHELL_EEPROM_QUEUE_LEN > 0
+
+#if defined(__AVR__) && defined(EE_READY_vect)
+#define SHELL_EEPROM_QUEUE_ISR
+#include <util/atomic.h>
+#define EEPROM_QUEUE_LOCK ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#if !defined(EEMPE) // older parts
+#define EEMPE EEMWE
+#define EEPE EEWE
+#endif
+#else
+#define EEPROM_QUEUE_LOCK
+#endif
+
+struct ShellEepromWrite
+{
+    uint16_t address;
+    uint8_t value;
+};
+
+static ShellEepromWrite queue_[SHELL_EEPROM_QUEUE_LEN];
+static volatile uint8_t queue_tail_; // oldest entry
+static volatile uint8_t queue_count_;
+
+// returns index of the newest pending write to the address or -1, must be called locked
+static int16_t findPending_(uint16_t address)
+{
+    int16_t found = -1;
+    uint8_t i = queue_tail_;
+    for (uint8_t n = queue_count_; n; n--)
+    {
+        if (queue_[i].address == address)
+            found = i;
+        if (++i == SHELL_EEPROM_QUEUE_LEN)
+            i = 0;
+    }
+    return found;
+}
+
+// removes the oldest entry, must be called locked
+static inline void pop_()
+{
+    if (++queue_tail_ == SHELL_EEPROM_QUEUE_LEN)
+        queue_tail_ = 0;
+    queue_count_--;
+}
+
+#if defined(SHELL_EEPROM_QUEUE_ISR)
+// level triggered while EEPROM is ready, writes one byte per interrupt
+ISR(EE_READY_vect)
+{
+    if (!queue_count_)
+    {
+        EECR &= ~_BV(EERIE);
+        return;
+    }
+    ShellEepromWrite &w = queue_[queue_tail_];
+    pop_(); // atomic with starting the write, so a read of a cell that is not pending waits for it
+    EEAR = w.address;
+    EECR |= _BV(EERE);
+    if (EEDR == w.value)
+        return;
+    EEDR = w.value;
+    EECR |= _BV(EEMPE);
+    EECR |= _BV(EEPE);
+}
+#endif
+
+// reads cells that are not pending
+static void readCells_(uint16_t address, uint8_t *data, uint8_t count)
+{
+#if defined(SHELL_EEPROM_QUEUE_ISR)
+    EEPROM_QUEUE_LOCK
+    {
+        EECR &= ~_BV(EERIE); // the interrupt handler shares EEAR and EEDR
+    }
+    eeprom_busy_wait(); // a read is ignored while a write is in progress
+    readBlock_(address, data, count);
+    EEPROM_QUEUE_LOCK
+    {
+        if (queue_count_)
+            EECR |= _BV(EERIE);
+    }
+#else
+    readBlock_(address, data, count);
+#endif
+}
+
+void shellEepromRead(uint16_t address, uint8_t *data, uint8_t count)
+{
+    bool pending = false;
+    EEPROM_QUEUE_LOCK
+    {
+        uint8_t i = queue_tail_;
+        for (uint8_t n = queue_count_; n; n--)
+        {
+            if ((uint16_t)(queue_[i].address - address) < count)
+                pending = true;
+            if (++i == SHELL_EEPROM_QUEUE_LEN)
+                i = 0;
+        }
+    }
+    if (!pending) // nothing can become pending while reading, only this context enqueues
+    {
+        readCells_(address, data, count);
+        return;
+    }
+    for (; count; count--, address++)
+    {
+        int16_t i;
+        uint8_t value = 0;
+        EEPROM_QUEUE_LOCK
+        {
+            i = findPending_(address);
+            if (i >= 0)
+                value = queue_[i].value;
+        }
+        if (i >= 0)
+            *data = value;
+        else
+            readCells_(address, data, 1);
+        data++;
+    }
+}
+
+void shellEepromWrite(uint16_t address, uint8_t value)
+{
+    for (;;)
+    {
+        EEPROM_QUEUE_LOCK
+        {
+            uint8_t head = queue_tail_ + queue_count_;
+            if (head >= SHELL_EEPROM_QUEUE_LEN)
+                head -= SHELL_EEPROM_QUEUE_LEN;
+            uint8_t last = head ? head - 1 : SHELL_EEPROM_QUEUE_LEN - 1;
+            // coalesce only with the newest write, an older entry would be written before the writes queued after it
+            if (queue_count_ && queue_[last].address == address)
+            {
+                queue_[last].value = value;
+                return;
+            }
+            if (queue_count_ < SHELL_EEPROM_QUEUE_LEN)
+            {
+                queue_[head].address = address;
+                queue_[head].value = value;
+                queue_count_++;
+#if defined(SHELL_EEPROM_QUEUE_ISR)
+                EECR |= _BV(EERIE);
+#endif
+                return;
+            }
+        }
+        shellEepromPoll(); // full
+    }
+}
+
+void shellEepromSync()
+{
+    while (queue_count_)
+        shellEepromPoll();
+#if defined(__AVR__)
+    eeprom_busy_wait(); // the last write was started but not completed
+#endif
+}
+
+uint8_t shellEepromPending()
+{
+    return queue_count_;
+}
+
+void shellEepromPoll()
+{
+#if !defined(SHELL_EEPROM_QUEUE_ISR)
+    if (!queue_count_)
+        return;
+#if defined(__AVR__)
+    if (!eeprom_is_ready())
+        return;
+#endif
+    ShellEepromWrite &w = queue_[queue_tail_];
+    if (EEPROM.read(w.address) != w.value)
+        EEPROM.write(w.address, w.value); // starts the write without waiting on AVR
+    pop_();
+#endif
+}
+
+#else
+
+void shellEepromRead(uint16_t address, uint8_t *data, uint8_t count)
+{
+    readBlock_(address, data, count);
+}
+
+void shellEepromWrite(uint16_t address, uint8_t value)
+{
+    if (EEPROM.read(address) != value) // unchanged cells are not written, saves time and wear
+        EEPROM.write(address, value);
+}
+
+void shellEepromSync()
+{
+}
+
+uint8_t shellEepromPending()
+{
+    return 0;
+}
+
+void shellEepromPoll()
+{
+}
+
+#endif
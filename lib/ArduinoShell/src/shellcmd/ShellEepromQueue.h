@@ -0,0 +1,43 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_EEPROM_QUEUE_H_
+#define _SHELL_EEPROM_QUEUE_H_
+#include <ShellCommon.h>
+
+// EEPROM access used by the EEPROM commands. With SHELL_EEPROM_QUEUE_LEN > 0 writes are queued
+// and drained in the background by the EE_READY interrupt on AVR, or one byte per shellEepromPoll() elsewhere.
+// Unchanged cells are never written.
+
+// Reads count bytes, pending writes are visible to reads
+void shellEepromRead(uint16_t address, uint8_t *data, uint8_t count);
+// Writes a byte, waits only when the queue is full
+void shellEepromWrite(uint16_t address, uint8_t value);
+// Waits until all pending writes are completed
+void shellEepromSync();
+// Number of pending writes
+uint8_t shellEepromPending();
+// Writes the next pending byte if EEPROM is ready, called by ShellController::tick()
+void shellEepromPoll();
+
+#endif //_SHELL_EEPROM_QUEUE_H_
@@ -0,0 +1,65 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "ShellHexWriter.h"
+
+const char shell_hex_digits[] PROGMEM = "0123456789ABCDEF";
+
+ShellHexWriter::ShellHexWriter(Print &out)
+{
+    out_ = &out;
+    len_ = 0;
+}
+
+void ShellHexWriter::writeChar(char c)
+{
+    if (len_ >= SHELL_HEX_CHUNK_LEN)
+        flush();
+    chunk_[len_++] = c;
+}
+
+void ShellHexWriter::writeDigit(uint8_t nibble)
+{
+    writeChar(pgm_read_byte_near(&shell_hex_digits[nibble & 0x0f]));
+}
+
+void ShellHexWriter::write(uint8_t value)
+{
+    if (len_ > SHELL_HEX_CHUNK_LEN - 2)
+        flush();
+    chunk_[len_++] = pgm_read_byte_near(&shell_hex_digits[value >> 4]);
+    chunk_[len_++] = pgm_read_byte_near(&shell_hex_digits[value & 0x0f]);
+}
+
+void ShellHexWriter::write(const uint8_t *data, uint16_t count)
+{
+    while (count--)
+        write(*(data++));
+}
+
+void ShellHexWriter::flush()
+{
+    if (len_)
+        out_->write((const uint8_t *)chunk_, len_);
+    len_ = 0;
+}
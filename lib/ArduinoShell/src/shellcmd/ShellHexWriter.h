@@ -0,0 +1,51 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _SHELL_HEX_WRITER_H_
+#define _SHELL_HEX_WRITER_H_
+#include <Arduino.h>
+
+// Size of the output chunk, digits are passed to the response in chunks instead of one write per digit
+#if !defined(SHELL_HEX_CHUNK_LEN)
+#define SHELL_HEX_CHUNK_LEN 32
+#endif
+
+// Writes bytes as uppercase hex digits using a nibble lookup table
+class ShellHexWriter
+{
+private:
+    Print *out_;
+    uint8_t len_;
+    char chunk_[SHELL_HEX_CHUNK_LEN];
+
+public:
+    ShellHexWriter(Print &out);
+    ~ShellHexWriter() { flush(); }
+    void write(uint8_t value); // always two digits
+    void write(const uint8_t *data, uint16_t count);
+    void writeChar(char c);
+    void writeDigit(uint8_t nibble); // lowest 4 bits
+    void flush();
+};
+
+#endif //_SHELL_HEX_WRITER_H_
@@ -25,6 +25,10 @@ SOFTWARE.
 
 #include <Shell.h>
 #include <ShellCmd.h>
+#ifdef ENV_NATIVE
+#include <stdio.h>
+#include <native/ShellHost.h>
+#endif
 
 DECLARE_COMMAND_HANDLER(LOGIN, "Logs in and enables user commands.");
 DECLARE_COMMAND_HANDLER(LOGOUT, "Logs out and disables user commands.");
@@ -36,7 +40,7 @@ COMMAND_HANDLER(VER, request, response, "Displays firmware version.")
 }
 
 DECLARE_SHELL_COMMANDS(user_commands){
-    SHELL_COMMAND(VER),
+    SHELL_COMMAND_THREADSAFE(VER),
     SHELL_COMMAND(PIN),
     SHELL_COMMAND(APIN),
     // SHELL_COMMAND(EEREAD),
@@ -52,15 +56,27 @@ DECLARE_SHELL_COMMANDS(login_commands){
     SHELL_COMMAND(HELP),
     END_SHELL_COMMANDS};
 
+#if SHELL_ADMIN_COMMANDS
 DECLARE_SHELL_COMMANDS(admin_commands){
     SHELL_COMMAND(EEREAD),
     SHELL_COMMAND(EEWRITE),
+#if SHELL_TRANSFER
+    SHELL_COMMAND(XFER),
+#endif
+#if defined(__AVR__) // raw memory access would expose the host process in the simulator
+    SHELL_COMMAND(PEEK),
+    SHELL_COMMAND(POKE),
+    SHELL_COMMAND(MEMDUMP),
+#endif
     END_SHELL_COMMANDS};
+#endif
 
 IMPLEMENT_COMMAND_HANDLER(LOGIN, request, response)
 {
     Shell.setUserCommands(user_commands);
+#if SHELL_ADMIN_COMMANDS
     Shell.setAdminCommands(admin_commands);
+#endif
     response.print(F("User commands are available."));
     return 0;
 }
@@ -68,7 +84,9 @@ IMPLEMENT_COMMAND_HANDLER(LOGIN, request, response)
 IMPLEMENT_COMMAND_HANDLER(LOGOUT, request, response)
 {
     Shell.setUserCommands(login_commands);
+#if SHELL_ADMIN_COMMANDS
     Shell.setAdminCommands(0);
+#endif
     response.print(F("Logged out."));
     return 0;
 }
@@ -92,9 +110,27 @@ void loop()
     Shell.tick();
 }
 
+#if defined(ENV_NATIVE) && SHELL_NATIVE_HOST
+// host side simulator with the same commands: pio run -e host && .pio/build/host/program
+ShellHost host(Shell);
+
+int main()
+{
+    setup();
+    if (!host.listenTcp(2323) || !host.listenUnix("/tmp/ashell.sock"))
+        return 1;
+    const char *pty = host.openPty();
+    printf("Listening on 127.0.0.1:2323, /tmp/ashell.sock and %s\n", pty ? pty : "(no pty)");
+    fflush(stdout);
+    while (host.poll(10))
+        ;
+    return 0;
+}
+#else
 int main()
 {
     setup();
     loop();
     return 0;
 }
+#endif
@@ -0,0 +1,290 @@
+/*
+MIT License
+
+Copyright (c) 2022 Serkan KAYGIN
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include <Shell.h>
+#include <BenchStream.h>
+#include <VirtualUart.h>
+
+// Native benchmarks, run with: pio test -e bench
+// Each result is printed as a single JSON line so it can be collected and compared between releases:
+// {"benchmark":"<name>","value":<value>,"unit":"<unit>"}
+
+#define handler(C, HSTR) COMMAND_HANDLER(C, request, response, HSTR)
+
+handler(VER, "Displays firmware version.")
+{
+    response.print(F("Tester Version 1.0"));
+    return 0;
+}
+
+#define BULK_RESPONSE_LEN 1024
+
+handler(BULK, "Prints a 1KB response.")
+{
+    for (int i = 0; i < BULK_RESPONSE_LEN; i++)
+        response.write('A' + (i & 15));
+    return 0;
+}
+
+IMPLEMENT_COMMAND_HANDLER(NOP, request, response)
+{
+    return 0;
+}
+
+DECLARE_SHELL_COMMANDS(user_commands){
+    SHELL_COMMAND(VER),
+    SHELL_COMMAND(BULK),
+    SHELL_COMMAND(HELP),
+    END_SHELL_COMMANDS};
+
+// forwards responses as they are, used to measure the cost of the framing layer itself
+class PassFraming : public ShellFraming
+{
+public:
+    virtual int8_t receive(Print *in, char c)
+    {
+        if (c == '\r')
+            return SHELL_FRAME_RECEIVED;
+        in->write(c);
+        return SHELL_FRAME_NOT_RECEIVED;
+    }
+};
+
+BenchStream bench;
+PassFraming pass_framing;
+
+static uint64_t nanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *name, double value, const char *unit)
+{
+    printf("{\"benchmark\":\"%s\",\"value\":%.1f,\"unit\":\"%s\"}\n", name, value, unit);
+}
+
+void setUp(void)
+{
+    Shell.setUserCommands(user_commands);
+}
+
+void tearDown(void)
+{
+}
+
+void bench_tick_throughput(void)
+{
+    const uint32_t count = 200000;
+    bench.setInput("VER\r", count);
+    uint32_t ticks = 0;
+    uint64_t start = nanos();
+    while (bench.available())
+    {
+        Shell.tick();
+        ticks++;
+    }
+    uint64_t elapsed = nanos() - start;
+    TEST_ASSERT_EQUAL_UINT32(count, ticks);
+    TEST_ASSERT_EQUAL_UINT32(count * strlen("Tester Version 1.0\r\n~"), bench.written);
+    report("tick_commands_per_sec", count * 1e9 / elapsed, "cmd/s");
+}
+
+// command tables are built at runtime, only possible where PROGMEM is ordinary memory
+#define MAX_BENCH_COMMANDS 200
+static char command_names[MAX_BENCH_COMMANDS][6];
+static char lookup_names[MAX_BENCH_COMMANDS][6]; // lowercase, so case folding is included
+static ShellCommandStruct command_table[MAX_BENCH_COMMANDS + 1];
+
+static void bench_find_command(uint16_t table_size, const char *name)
+{
+    for (uint16_t i = 0; i < table_size; i++)
+    {
+        snprintf(command_names[i], sizeof(command_names[i]), "C%03u", i);
+        snprintf(lookup_names[i], sizeof(lookup_names[i]), "c%03u", i);
+        command_table[i] = (ShellCommandStruct){command_names[i], &_shell_handle_NOP, command_names[i]};
+    }
+    command_table[table_size] = (ShellCommandStruct){0, 0, 0};
+    Shell.setUserCommands(command_table);
+    const uint32_t rounds = 2000000 / table_size;
+    uint32_t found = 0;
+    uint64_t start = nanos();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        for (uint16_t i = 0; i < table_size; i++) // every command is looked up once per round
+            if (Shell.findCommandDefinition(lookup_names[i]))
+                found++;
+    }
+    uint64_t elapsed = nanos() - start;
+    TEST_ASSERT_EQUAL_UINT32(rounds * table_size, found);
+    report(name, (double)elapsed / (rounds * table_size), "ns/lookup");
+}
+
+void bench_find_command_5(void)
+{
+    bench_find_command(5, "find_command_5");
+}
+
+void bench_find_command_50(void)
+{
+    bench_find_command(50, "find_command_50");
+}
+
+void bench_find_command_200(void)
+{
+    bench_find_command(200, "find_command_200");
+}
+
+void bench_argument_reader(void)
+{
+    const char line[] = "1 22 333 0x4444 0b101 -66 7777 88";
+    const uint8_t args = 8;
+    const uint32_t count = 500000;
+    byte buf[sizeof(line)];
+    ArgumentReader reader;
+    uint32_t parsed = 0;
+    uint64_t start = nanos();
+    for (uint32_t n = 0; n < count; n++)
+    {
+        memcpy(buf, line, sizeof(line)); // parsing modifies the buffer
+        reader.begin(buf);
+        int16_t value;
+        for (uint8_t i = 0; i < args; i++)
+            if (reader.readInt(&value) > 0)
+                parsed++;
+    }
+    uint64_t elapsed = nanos() - start;
+    TEST_ASSERT_EQUAL_UINT32(count * args, parsed);
+    report("argument_reader", (double)elapsed / (count * args), "ns/arg");
+}
+
+// Simulated serial line on a virtual clock, the results do not depend on the host machine.
+// Each loop() iteration is assumed to take UART_LOOP_NS besides the shell.
+#define UART_LOOP_NS 50000ULL
+#define UART_BURST_COMMANDS 50
+
+static uint32_t count_prompts(const std::string &s)
+{
+    uint32_t n = 0;
+    for (size_t i = 0; i < s.size(); i++)
+        if (s[i] == '~')
+            n++;
+    return n;
+}
+
+static void bench_uart(uint32_t baud)
+{
+    char name[48];
+    VirtualClock clock;
+    VirtualUart uart(clock, baud);
+    Shell.addEndpoint(uart);
+    // closed loop, next request is sent when the prompt of the previous one is received
+    const uint32_t count = 100;
+    uint64_t latency = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t start = clock.now();
+        uart.hostWrite("VER\r");
+        while (count_prompts(uart.hostRead()) == 0)
+        {
+            clock.advance(UART_LOOP_NS);
+            Shell.tick();
+        }
+        latency += clock.now() - start;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, uart.rx_dropped);
+    sprintf(name, "uart_%lu_latency_us", (unsigned long)baud);
+    report(name, latency / 1000.0 / count, "us");
+    sprintf(name, "uart_%lu_stall_us_per_cmd", (unsigned long)baud);
+    report(name, uart.stall_ns / 1000.0 / count, "us");
+    // open loop, all requests are sent at once and the RX FIFO overflows while the shell is blocked
+    uart.rx_dropped = 0;
+    for (uint32_t i = 0; i < UART_BURST_COMMANDS; i++)
+        uart.hostWrite("VER\r");
+    uint32_t prompts = 0;
+    while (!uart.hostIdle())
+    {
+        clock.advance(UART_LOOP_NS);
+        Shell.tick();
+        prompts += count_prompts(uart.hostRead());
+    }
+    TEST_ASSERT_TRUE(prompts > 0 && prompts <= UART_BURST_COMMANDS);
+    sprintf(name, "uart_%lu_burst_dropped_bytes", (unsigned long)baud);
+    report(name, uart.rx_dropped, "B");
+    Shell.removeEndpoint(uart);
+}
+
+void bench_uart_9600(void)
+{
+    bench_uart(9600);
+}
+
+void bench_uart_115200(void)
+{
+    bench_uart(115200);
+}
+
+static void bench_framing(ShellFraming *framing, const char *name)
+{
+    Shell.setFraming(framing); // applied after the next response
+    Shell.exec(F("VER"), bench);
+    const uint32_t count = 20000;
+    bench.setInput("BULK\r", count);
+    uint64_t start = nanos();
+    while (bench.available())
+        Shell.tick();
+    uint64_t elapsed = nanos() - start;
+    TEST_ASSERT_TRUE(bench.written >= count * BULK_RESPONSE_LEN);
+    report(name, bench.written * 1e9 / elapsed, "B/s");
+}
+
+void bench_default_framing(void)
+{
+    bench_framing(0, "default_framing_bytes_per_sec");
+}
+
+void bench_pass_framing(void)
+{
+    bench_framing(&pass_framing, "pass_framing_bytes_per_sec");
+}
+
+int main(int argc, char **argv)
+{
+    Shell.begin(user_commands, F("~"));
+    Shell.addEndpoint(bench);
+    UNITY_BEGIN();
+    RUN_TEST(bench_tick_throughput);
+    RUN_TEST(bench_find_command_5);
+    RUN_TEST(bench_find_command_50);
+    RUN_TEST(bench_find_command_200);
+    RUN_TEST(bench_argument_reader);
+    RUN_TEST(bench_uart_9600);
+    RUN_TEST(bench_uart_115200);
+    RUN_TEST(bench_default_framing);
+    RUN_TEST(bench_pass_framing);
+    UNITY_END();
+    return 0;
+}
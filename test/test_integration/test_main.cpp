@@ -24,10 +24,14 @@ SOFTWARE.
 #include <Arduino.h>
 #include <unity.h>
 #include <Shell.h>
+#include <ShellCmd.h>
+#include <shellcmd/ShellEepromQueue.h>
+#include <shellcmd/ShellCrc32.h>
 #include <TesterStream.h>
 
 TesterStream tester;
 TesterStream tester2;
+TesterStream tester3;
 ArgumentReader arg;
 
 // pio ci src/main.cpp  --lib="./lib/ArduinoShell/src" --board=nanoatmega168 --board=uno --board=megaatmega2560 --board=leonardo
@@ -54,6 +58,13 @@ handler(TEST, "Used for unit testing. <month>")
     return 0;
 }
 
+handler(CNT, "Counts its runs.")
+{
+    static uint16_t runs = 0;
+    response.print(++runs);
+    return 0;
+}
+
 // dot at the end is deliberately missing
 handler(A, "Short command no dot")
 {
@@ -105,6 +116,24 @@ DECLARE_SHELL_COMMANDS(user_commands){
     SHELL_COMMAND(TEST),
     SHELL_COMMAND(A),
     SHELL_COMMAND(WHO),
+    SHELL_COMMAND(EVERY),
+    SHELL_COMMAND(STATS),
+    SHELL_COMMAND(EEREAD),
+    SHELL_COMMAND(EEWRITE),
+    SHELL_COMMAND(EESYNC),
+    SHELL_COMMAND(EECRC),
+    SHELL_COMMAND(EECMP),
+    SHELL_COMMAND(XFER),
+    SHELL_COMMAND(CONFIG),
+    SHELL_COMMAND(PIN),
+    SHELL_COMMAND(PORT),
+    SHELL_COMMAND(APIN),
+    SHELL_COMMAND(SAMPLE),
+    SHELL_COMMAND(WATCH),
+    SHELL_COMMAND(PEEK),
+    SHELL_COMMAND(POKE),
+    SHELL_COMMAND(MEMDUMP),
+    SHELL_COMMAND(CNT),
     SHELL_COMMAND(HELP),
     END_SHELL_COMMANDS};
 
@@ -253,6 +282,588 @@ void test_error_messages()
     tester.execute(F("A -128\r"));
     TEST_ASSERT_EQUAL_STRING(tester.response(), ("ERR:Custom-Error-128\r\n~"));
 }
+void test_every_command()
+{
+    tester.execute(F("EVERY 50 VER\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0\r\n~"));
+    Shell.tick(); // first run is immediate
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester Version 1.0\r\n~"));
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester.response(), (""));
+    delay(60);
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester Version 1.0\r\n~"));
+    tester.execute(F("EVERY 5 -c WHO\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("1\r\n~"));
+    tester.execute(F("EVERY\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0 50 VER\r\n1 5 -c WHO\r\n~"));
+    tester.execute(F("EVERY -d 0\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester\r\n~"));
+    delay(10);
+    Shell.tick(); // unchanged output is suppressed
+    TEST_ASSERT_EQUAL_STRING(tester.response(), (""));
+    tester.execute(F("EVERY -d 1\r"));
+    tester.execute(F("EVERY 5 -c CNT\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0\r\n~"));
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("1\r\n~"));
+    delay(10);
+    Shell.tick(); // runs once per interval, also when the output changes
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("2\r\n~"));
+    tester.execute(F("EVERY 5 NOSUCHCMD\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("ERR:Bad or missing argument\r\n~"));
+    tester.execute(F("EVERY -d\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EVERY\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+}
+
+void test_events()
+{
+    tester2.response();
+    TEST_ASSERT_TRUE(Shell.emitEvent(F("ALARM"), &tester));
+    TEST_ASSERT_TRUE(Shell.emitEvent(F("ALL")));
+    TEST_ASSERT_FALSE(Shell.emitEvent(F("THIS EVENT IS LONGER THAN THE EVENT BUFFER")));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), (""));
+    tester.execute(F("VER\r")); // events never interleave with the response
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester Version 1.0\r\n~EVT:ALARM\r\n~EVT:ALL\r\n~"));
+    TEST_ASSERT_EQUAL_STRING(tester2.response(), ("EVT:ALL\r\n~"));
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester.response(), (""));
+}
+
+void test_stats_command()
+{
+    tester.execute(F("STATS -r\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("A 1\r"));
+    tester.execute(F("A -5\r"));
+    tester.execute(F("a\r"));
+    tester.execute(F("STATS a\r"));
+    char *str = tester.response();
+    TEST_ASSERT_EQUAL_STRING_LEN("A         3 2 ", str, 14);
+    TEST_ASSERT_NOT_NULL(strstr(str, "\r\nERR:Custom-Error 1\r\nERR:Bad or missing argument 1\r\n~"));
+    tester.execute(F("STATS\r"));
+    str = tester.response();
+    TEST_ASSERT_EQUAL_STRING_LEN("STATS     2 0 ", str, 14);
+    TEST_ASSERT_NOT_NULL(strstr(str, "\r\nA         3 2 "));
+}
+
+void test_endpoint_stats()
+{
+    Shell.resetEndpointStats();
+    tester.execute(F("\r"));
+    tester.execute(F("ABCDEFGHI 0123456789012345678901234567890123456789012345678901234567890123456789x\r"));
+    const ShellEndpointStats *st = Shell.getEndpointStats(tester);
+    TEST_ASSERT_EQUAL_UINT32(83, st->bytes_in);
+    TEST_ASSERT_EQUAL_UINT32(26, st->bytes_out);
+    TEST_ASSERT_EQUAL_UINT32(2, st->frames);
+    TEST_ASSERT_EQUAL_UINT16(0, st->bad_frames);
+    TEST_ASSERT_EQUAL_UINT16(1, st->overlong_lines);
+    TEST_ASSERT_EQUAL_UINT16(1, st->empty_lines);
+    TEST_ASSERT_EQUAL_UINT16(81, st->max_line_len);
+    tester.execute(F("STATS -e\r")); // bytes out includes the part of this response printed before it
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0* 92 32 3 0 1 1 81\r\n1 0 0 0 0 0 0 0\r\n~"));
+}
+
+void test_tick_profiler()
+{
+    Shell.resetTickProfile();
+    Shell.tick();
+    tester.input(F("VE"));
+    Shell.tick();
+    tester.execute(F("R\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester Version 1.0\r\n~"));
+    const ShellTickProfile *profile = Shell.getTickProfile();
+    for (uint8_t phase = 0; phase < SHELL_TICK_PHASE_COUNT; phase++)
+    {
+        uint16_t ticks = 0;
+        for (uint8_t bucket = 0; bucket < SHELL_TICK_PROFILE_BUCKETS; bucket++)
+            ticks += profile->histogram[phase][bucket];
+        TEST_ASSERT_EQUAL_UINT16(1, ticks);
+    }
+    TEST_ASSERT_NOT_NULL(profile->max_command);
+    TEST_ASSERT_EQUAL_INT(0, strcmp_P("VER", (PGM_P)pgm_read_ptr_near(&(profile->max_command->command))));
+}
+
+void test_endpoint_readiness()
+{
+    ShellEndpoint node, other;
+    Shell.addEndpoint(node, tester3, true);
+    Shell.addEndpoint(node, tester3, true); // duplicates are ignored
+    Shell.addEndpoint(other, tester3, true);
+    TEST_ASSERT_NULL(other.stream);
+    tester3.execute(F("VER\r")); // not polled until marked ready
+    TEST_ASSERT_EQUAL_STRING(tester3.response(), (""));
+    Shell.markReady(node);
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester3.response(), ("Tester Version 1.0\r\n~"));
+    TEST_ASSERT_FALSE(node.ready); // nothing left to read
+    tester3.reset_response();
+    tester3.input(F("VER\rVER\r"));
+    Shell.markReady(node);
+    Shell.tick();
+    TEST_ASSERT_TRUE(node.ready); // stays ready until drained
+    Shell.removeEndpoint(node);
+    TEST_ASSERT_NULL(node.stream);
+    TEST_ASSERT_FALSE(node.ready);
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester3.response(), ("Tester Version 1.0\r\n~"));
+    while (tester3.available()) // drops the second request
+        tester3.read();
+}
+
+// wraps responses in brackets, requests end with '!'
+class BracketFraming : public ShellFraming
+{
+public:
+    virtual int8_t receive(Print *in, char c)
+    {
+        if (c == '!')
+            return SHELL_FRAME_RECEIVED;
+        in->write(c);
+        return SHELL_FRAME_NOT_RECEIVED;
+    }
+    virtual void beginSend(Print *out) { out->write('['); }
+    virtual void endSend(Print *out) { out->write(']'); }
+};
+
+void test_endpoint_framing()
+{
+    BracketFraming framing;
+    Shell.removeEndpoint(tester2);
+    Shell.addEndpoint(tester2, &framing);
+    tester2.execute(F("VER!"));
+    TEST_ASSERT_EQUAL_STRING(tester2.response(), ("[Tester Version 1.0]"));
+    tester.execute(F("VER\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester Version 1.0\r\n~"));
+    tester2.execute(F("XYZ!"));
+    TEST_ASSERT_EQUAL_STRING(tester2.response(), ("[ERR:Unknown command]"));
+    Shell.removeEndpoint(tester2);
+    Shell.addEndpoint(tester2);
+}
+
+void test_ingress_queue()
+{
+    Shell.setIngressOutput(&tester2);
+    TEST_ASSERT_TRUE(Shell.post("VER"));
+    TEST_ASSERT_TRUE(Shell.post(F("XYZ")));
+    TEST_ASSERT_FALSE(Shell.post(""));
+    TEST_ASSERT_FALSE(Shell.post(F("VER 0123456789012345678901234567890123456789012345678901234567890123456789012345")));
+    tester2.reset_response();
+    tester.input(F("VE")); // partially received request is not affected
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester2.response(), ("Tester Version 1.0\r\n~"));
+    tester.execute(F("R\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("Tester Version 1.0\r\n~"));
+    tester2.reset_response();
+    Shell.tick();
+    TEST_ASSERT_EQUAL_STRING(tester2.response(), ("ERR:Unknown command\r\n~"));
+    // fills the queue, lines do not fit after the last free cell
+    uint8_t posted = 0;
+    while (Shell.post("VER"))
+        posted++;
+    TEST_ASSERT_EQUAL_UINT8((SHELL_INGRESS_QUEUE_LEN - 1) / 4, posted);
+    Shell.setIngressOutput(0);
+    for (uint8_t i = 0; i < posted; i++)
+        Shell.tick();
+    TEST_ASSERT_TRUE(Shell.post("VER"));
+    Shell.tick();
+}
+
+void test_eeprom_commands()
+{
+    tester.execute(F("EEWRITE 100 0a1B2c\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EEWRITE 101 1B\r")); // unchanged, skipped
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EEREAD 100 3\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0A1B2C\r\n~"));
+    tester.execute(F("EEWRITE 0 00112233445566778899AABBCCDDEEFF0F1E2D3C4B5A69788796A5B4C3D2E1F0\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EEREAD 0 32\r")); // spans hex chunks and read blocks
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("00112233445566778899AABBCCDDEEFF0F1E2D3C4B5A69788796A5B4C3D2E1F0\r\n~"));
+    tester.execute(F("EECRC 0 32\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("28ED27D1\r\n~"));
+    tester.execute(F("EECMP 0 16 8407759b F8295E60\r")); // all blocks match
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EECMP 0 16 00000000 F8295E60 12345678\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0 32\r\n~"));
+    tester.execute(F("EECMP 0 16 F8295E6\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("ERR:Bad or missing argument\r\n~"));
+    tester.execute(F("EECRC 4090 8\r")); // past the end
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("ERR:Bad or missing argument\r\n~"));
+    tester.execute(F("EECMP 4080 8 00000000 00000000 00000000\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("ERR:Bad or missing argument\r\n~"));
+    tester.execute(F("EECMP 4080 8 00000000 00000000\r")); // last blocks, offsets are unsigned
+    TEST_ASSERT_EQUAL_STRING_LEN("4080", tester.response(), 4);
+}
+
+// sends one XFER block, data is seq + i
+void xfer_put_block(uint8_t seq, uint8_t len, bool corrupt = false)
+{
+    uint8_t frame[3 + SHELL_XFER_BLOCK_LEN + 4] = {SHELL_XFER_SOH, seq, len};
+    for (uint8_t i = 0; i < len; i++)
+        frame[3 + i] = seq + i;
+    uint32_t crc = shellCrc32(0, &frame[1], 2 + len);
+    for (uint8_t i = 0; i < 4; i++, crc >>= 8)
+        frame[3 + len + i] = crc;
+    if (corrupt)
+        frame[3]++;
+    tester.input(frame, 3 + len + 4);
+    Shell.tick();
+}
+
+void test_xfer()
+{
+    tester.execute(F("XFER EE PUT 300 70\r"));
+    TEST_ASSERT_EQUAL_STRING("64 4\r\n~", tester.response());
+    xfer_put_block(0, 64);
+    TEST_ASSERT_EQUAL_INT(2, tester.responseLength());
+    TEST_ASSERT_EQUAL_MEMORY("\x06\x00", tester.response(), 2);
+    TesterStream other;
+    Shell.addEndpoint(other);
+    other.execute(F("XFER EE GET 100 5\r")); // one transfer at a time, the running one is not touched
+    TEST_ASSERT_EQUAL_STRING("ERR:Illegal state\r\n~", other.response());
+    Shell.removeEndpoint(other);
+    xfer_put_block(1, 6, true); // bad crc
+    TEST_ASSERT_EQUAL_MEMORY("\x15\x01", tester.response(), 2);
+    xfer_put_block(0, 64); // duplicate, ACK is repeated
+    TEST_ASSERT_EQUAL_MEMORY("\x06\x00", tester.response(), 2);
+    xfer_put_block(1, 6);
+    TEST_ASSERT_EQUAL_MEMORY("\x06\x01", tester.response(), 2);
+    tester.execute(F("EEREAD 362 8\r")); // back to commands
+    TEST_ASSERT_EQUAL_STRING("3E3F010203040506\r\n~", tester.response());
+
+    tester.execute(F("XFER EE GET 362 70\r"));
+    TEST_ASSERT_EQUAL_INT(7 + 71, tester.responseLength()); // response and the first block
+    uint8_t *r = (uint8_t *)tester.response() + 7;
+    TEST_ASSERT_EQUAL_MEMORY("\x01\x00\x40\x3E\x3F\x01", r, 6);
+    TEST_ASSERT_EQUAL_UINT32(shellCrc32(0, r + 1, 66), (uint32_t)r[67] | (uint32_t)r[68] << 8 | (uint32_t)r[69] << 16 | (uint32_t)r[70] << 24);
+    Shell.tick();
+    TEST_ASSERT_EQUAL_INT(7 + 6, tester.responseLength()); // window allows sending before the ACK, last block is shorter
+    tester.response();
+    tester.input((const uint8_t *)"\x15\x00", 2); // NAK goes back to the first block
+    Shell.tick();
+    TEST_ASSERT_EQUAL_INT(71, tester.responseLength());
+    TEST_ASSERT_EQUAL_UINT8(0, tester.response()[1]);
+    tester.input((const uint8_t *)"\x06\x00", 2);
+    Shell.tick();
+    TEST_ASSERT_EQUAL_INT(7 + 6, tester.responseLength()); // resent after the first one
+    tester.response();
+    tester.input((const uint8_t *)"\x06\x01", 2);
+    Shell.tick();
+    tester.execute(F("VER\r"));
+    TEST_ASSERT_EQUAL_STRING("Tester Version 1.0\r\n~", tester.response());
+
+    tester.execute(F("XFER EE PUT 0 10\r"));
+    tester.response();
+    tester.input((const uint8_t *)"\x18", 1); // cancelled by the host
+    Shell.tick();
+    tester.execute(F("VER\r"));
+    TEST_ASSERT_EQUAL_STRING("Tester Version 1.0\r\n~", tester.response());
+    tester.execute(F("XFER EE GET 4090 10\r")); // past the end
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    tester.execute(F("XFER EE SEND 0 10\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+}
+
+void test_config_store()
+{
+    TEST_ASSERT_FALSE(Config.begin(PSTR("NAME|RATE|MODE"), 1000, 24)); // formats the region
+    tester.execute(F("CONFIG LIST\r"));
+    TEST_ASSERT_EQUAL_STRING("\r\n~", tester.response());
+    tester.execute(F("CONFIG SET name Sensor 1\r"));
+    TEST_ASSERT_EQUAL_STRING("\r\n~", tester.response());
+    tester.execute(F("CONFIG GET NAME\r"));
+    TEST_ASSERT_EQUAL_STRING("Sensor 1\r\n~", tester.response());
+    tester.execute(F("CONFIG SET RATE 100\r"));
+    tester.execute(F("CONFIG SET RATE 200\r"));
+    tester.execute(F("CONFIG SET RATE 300\r")); // log is full, compacted
+    TEST_ASSERT_EQUAL_STRING("\r\n~", tester.response());
+    tester.execute(F("CONFIG LIST\r"));
+    TEST_ASSERT_EQUAL_STRING("NAME=Sensor 1\r\nRATE=300\r\n~", tester.response());
+    tester.execute(F("CONFIG SET MODE a value that does not fit\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:I/O error\r\n~", tester.response());
+    tester.execute(F("CONFIG GET SPEED\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+
+    TEST_ASSERT_TRUE(Config.begin(PSTR("NAME|RATE|MODE"), 1000, 24)); // index is rebuilt as after a reset
+    char value[8];
+    TEST_ASSERT_EQUAL_INT16(3, Config.get(1, value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("300", value);
+    tester.execute(F("CONFIG SET RATE\r")); // removes
+    tester.execute(F("CONFIG LIST\r"));
+    TEST_ASSERT_EQUAL_STRING("NAME=Sensor 1\r\n~", tester.response());
+    TEST_ASSERT_EQUAL_INT16(-1, Config.get(1, value, sizeof(value)));
+
+    tester.execute(F("CONFIG SET MODE fast\r"));
+    TEST_ASSERT_TRUE(Config.begin(PSTR("NAME|RATE"), 1000, 24)); // MODE is skipped, not erased
+    TEST_ASSERT_TRUE(Config.isSet(0));
+    TEST_ASSERT_TRUE(Config.begin(PSTR("NAME|RATE|MODE"), 1000, 24));
+    TEST_ASSERT_EQUAL_INT16(4, Config.get(2, value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("fast", value);
+}
+
+void test_pin_list()
+{
+    tester.execute(F("PIN 22,23 OUTPUT\r"));
+    TEST_ASSERT_EQUAL_STRING("22,23 OUTPUT\r\n~", tester.response());
+    tester.execute(F("PIN 22,23 HIGH\r"));
+    TEST_ASSERT_EQUAL_STRING("22,23 HIGH\r\n~", tester.response());
+    tester.execute(F("PIN 22 LOW\r"));
+    TEST_ASSERT_EQUAL_STRING("22 LOW\r\n~", tester.response());
+    tester.execute(F("PIN 22,23\r"));
+    TEST_ASSERT_EQUAL_STRING("22,23 LOW,HIGH\r\n~", tester.response());
+    tester.execute(F("PIN 22,X HIGH\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+#if defined(__AVR__)
+    tester.execute(F("PORT A OUT 0x01 0x03\r")); // pins 22,23 are PA0,PA1
+    TEST_ASSERT_EQUAL_STRING("0x01\r\n~", tester.response());
+    tester.execute(F("PIN 22,23\r"));
+    TEST_ASSERT_EQUAL_STRING("22,23 HIGH,LOW\r\n~", tester.response());
+    tester.execute(F("PORT A DDR\r"));
+    TEST_ASSERT_EQUAL_STRING("0x03\r\n~", tester.response());
+    tester.execute(F("PORT Z\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+#else
+    tester.execute(F("PORT A\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Illegal operation\r\n~", tester.response());
+#endif
+}
+
+void test_analog_scan()
+{
+    tester.execute(F("APIN 3 128\r"));
+    TEST_ASSERT_EQUAL_STRING("3 128\r\n~", tester.response());
+    tester.execute(F("APIN -n 65 1\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    tester.execute(F("APIN -x 1\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    tester.execute(F("APIN -f\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    // analog inputs are floating on the test board, only the format is checked
+    unsigned int values[3];
+    tester.execute(F("APIN 5\r"));
+    TEST_ASSERT_EQUAL_INT(1, sscanf(tester.response(), "5 %u\r\n~", &values[0]));
+    TEST_ASSERT_TRUE(values[0] < 1024);
+    tester.execute(F("APIN -f -n 4 0,1,2\r"));
+    TEST_ASSERT_EQUAL_INT(3, sscanf(tester.response(), "0,1,2 %u,%u,%u\r\n~", &values[0], &values[1], &values[2]));
+    TEST_ASSERT_TRUE(values[0] < 1024 && values[1] < 1024 && values[2] < 1024);
+}
+
+void test_sample_capture()
+{
+    tester.execute(F("SAMPLE 1,13 1000 5\r"));
+    TEST_ASSERT_EQUAL_STRING("1000\r\n~", tester.response());
+    tester.execute(F("SAMPLE 1 100 1\r")); // one capture at a time
+    TEST_ASSERT_EQUAL_STRING("ERR:Illegal state\r\n~", tester.response());
+    uint32_t start = millis();
+    while (millis() - start < 50)
+        Shell.tick();
+    char *events = tester.response();
+    TEST_ASSERT_EQUAL_STRING_LEN("EVT:SMP 0 ", events, 10);
+    TEST_ASSERT_NOT_NULL(strstr(events, "EVT:SMP END 5 "));
+    // inputs are floating, the samples are decoded and checked for range
+    int16_t prev[2] = {0, 0};
+    uint8_t samples = 0;
+    bool valid = true;
+    for (char *c = events + 10; valid && *c != '\r'; samples++)
+    {
+        unsigned int token, value;
+        valid = sscanf(c, "%2x", &token) == 1;
+        c += 2;
+        if (token == 0xff) // escaped absolute value
+        {
+            valid = valid && sscanf(c, "%3x", &value) == 1;
+            c += 3;
+        }
+        else
+            value = prev[samples % 2] + (token & 1 ? -(int16_t)((token + 1) >> 1) : (int16_t)(token >> 1));
+        valid = valid && value < 1024;
+        prev[samples % 2] = value;
+    }
+    TEST_ASSERT_TRUE(valid);
+    TEST_ASSERT_EQUAL_UINT8(10, samples); // 5 rounds of 2 channels
+    tester.execute(F("SAMPLE 1 1000 0\r")); // until stopped
+    tester.response();
+    tester.execute(F("SAMPLE STOP\r"));
+    start = millis();
+    while (millis() - start < 20)
+        Shell.tick();
+    TEST_ASSERT_NOT_NULL(strstr(tester.response(), "EVT:SMP END "));
+    tester.execute(F("SAMPLE 1,2 0 5\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+}
+
+static void pulse(uint8_t pin, uint16_t high_us, uint16_t low_us)
+{
+    uint32_t start = micros();
+    digitalWrite(pin, HIGH);
+    while ((uint32_t)(micros() - start) < high_us)
+        ;
+    digitalWrite(pin, LOW);
+    while ((uint32_t)(micros() - start) < (uint32_t)high_us + low_us)
+        ;
+}
+
+void test_watch_edges()
+{
+    pinMode(2, OUTPUT); // interrupts are triggered by writes to output pins
+    digitalWrite(2, LOW);
+    tester.execute(F("WATCH 5\r")); // not an interrupt pin
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    tester.execute(F("WATCH 2\r"));
+    TEST_ASSERT_EQUAL_STRING("0\r\n~", tester.response());
+    tester.execute(F("WATCH 2 RISING\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Illegal state\r\n~", tester.response());
+    for (uint8_t i = 0; i < 4; i++)
+        pulse(2, 200, 600);
+    Shell.tick(); // a full block is sent without waiting
+    char *events = tester.response();
+    TEST_ASSERT_EQUAL_STRING_LEN("EVT:EDG 0 H", events, 11);
+    uint8_t edges = 0;
+    for (char *c = events; *c; c++)
+        edges += *c == ' ' && (c[1] == 'H' || c[1] == 'L');
+    TEST_ASSERT_EQUAL_UINT8(8, edges);
+
+    tester.execute(F("WATCH STAT\r"));
+    char *stat = tester.response();
+    unsigned long count, min, avg, max;
+    TEST_ASSERT_EQUAL_STRING_LEN("EDGES 8 0\r\nHIGH 4 ", stat, 18);
+    TEST_ASSERT_EQUAL_INT(4, sscanf(strstr(stat, "HIGH"), "HIGH %lu %lu %lu %lu", &count, &min, &avg, &max));
+    TEST_ASSERT_TRUE(avg > 150 && avg < 300);
+    TEST_ASSERT_EQUAL_INT(4, sscanf(strstr(stat, "LOW"), "LOW %lu %lu %lu %lu", &count, &min, &avg, &max));
+    TEST_ASSERT_EQUAL_UINT32(3, count); // the first low level started before WATCH
+    TEST_ASSERT_TRUE(avg > 450 && avg < 750);
+    TEST_ASSERT_EQUAL_INT(4, sscanf(strstr(stat, "PERIOD"), "PERIOD %lu %lu %lu %lu", &count, &min, &avg, &max));
+    TEST_ASSERT_EQUAL_UINT32(6, count);
+    TEST_ASSERT_NOT_NULL(strstr(stat, "FREQ 1"));
+    tester.execute(F("WATCH STAT -r\r"));
+    tester.execute(F("WATCH STAT\r"));
+    TEST_ASSERT_EQUAL_STRING_LEN("EDGES 8 0\r\nHIGH 0 0 0 0\r\n", tester.response(), 25);
+
+    tester.execute(F("WATCH STOP\r")); // the task runs in the same tick
+    TEST_ASSERT_EQUAL_STRING("\r\n~EVT:EDG END 8 0\r\n~", tester.response());
+
+    tester.execute(F("WATCH 2 FALLING\r"));
+    tester.response();
+    for (uint8_t i = 0; i < SHELL_WATCH_BUFFER_LEN + 8; i++)
+        pulse(2, 20, 20);
+    uint32_t start = millis();
+    while (millis() - start < SHELL_WATCH_INTERVAL_MS + 20) // the last block is not full
+        Shell.tick();
+    // the buffer keeps one slot free, edges after the dropped ones would follow LOST
+    events = tester.response();
+    TEST_ASSERT_EQUAL_STRING_LEN("EVT:EDG 0 L", events, 11);
+    TEST_ASSERT_NOT_NULL(strstr(events, "~EVT:EDG 24 L"));
+    TEST_ASSERT_NOT_NULL(strstr(events, "\r\n~EVT:EDG LOST 9\r\n~"));
+    pulse(2, 20, 20); // the first edge after the lost ones does not count as a period
+    pulse(2, 20, 20);
+    start = millis();
+    while (millis() - start < SHELL_WATCH_INTERVAL_MS + 20)
+        Shell.tick();
+    tester.response();
+    tester.execute(F("WATCH STAT\r"));
+    stat = tester.response();
+    TEST_ASSERT_EQUAL_INT(4, sscanf(strstr(stat, "PERIOD"), "PERIOD %lu %lu %lu %lu", &count, &min, &avg, &max));
+    TEST_ASSERT_EQUAL_UINT32(31, count);
+    TEST_ASSERT_TRUE(max < SHELL_WATCH_INTERVAL_MS * 1000UL);
+    tester.execute(F("WATCH STOP\r"));
+    TEST_ASSERT_EQUAL_STRING("\r\n~EVT:EDG END 33 9\r\n~", tester.response());
+}
+
+static volatile uint32_t mem_word __attribute__((aligned(4))) = 0x12345678;
+static const uint8_t mem_flash[20] PROGMEM = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+
+static void executeAt(const char *format, const volatile void *addr)
+{
+    char line[64];
+    snprintf(line, sizeof(line), format, (unsigned long)(uintptr_t)addr);
+    tester.reset_response();
+    tester.input((const uint8_t *)line, strlen(line));
+    Shell.tick(true);
+}
+
+void test_memory_commands()
+{
+    uint8_t *word = (uint8_t *)&mem_word;
+    executeAt("PEEK -w 32 0x%lX\r", word);
+    TEST_ASSERT_EQUAL_STRING("12345678\r\n~", tester.response());
+    executeAt("PEEK %lu\r", word); // little endian
+    TEST_ASSERT_EQUAL_STRING("78\r\n~", tester.response());
+    executeAt("PEEK -w 16 0x%lX\r", word + 2);
+    TEST_ASSERT_EQUAL_STRING("1234\r\n~", tester.response());
+    executeAt("PEEK -w 32 0x%lX\r", word + 2); // unaligned
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+
+    executeAt("POKE -w 16 0x%lX 0xBEEF\r", word);
+    TEST_ASSERT_EQUAL_STRING("\r\n~", tester.response());
+    TEST_ASSERT_EQUAL_UINT32(0x1234BEEF, mem_word);
+    executeAt("POKE 0x%lX 0xA5 0x0F\r", word); // only the low nibble
+    TEST_ASSERT_EQUAL_UINT32(0x1234BEE5, mem_word);
+    executeAt("POKE 0x%lX 0x100\r", word); // does not fit
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    TEST_ASSERT_EQUAL_UINT32(0x1234BEE5, mem_word);
+
+    executeAt("MEMDUMP 0x%lX 4\r", word);
+    char *str = tester.response();
+    TEST_ASSERT_EQUAL_STRING(" E5BE3412\r\n~", str + strlen(str) - 12);
+    executeAt("MEMDUMP -b 0x%lX 4\r", word);
+    TEST_ASSERT_EQUAL_INT(9, tester.responseLength());
+    TEST_ASSERT_EQUAL_MEMORY("4:\xE5\xBE\x34\x12\r\n~", tester.response(), 9);
+
+    executeAt("PEEK -f -w 16 0x%lX\r", mem_flash + 1); // flash reads need no alignment
+    TEST_ASSERT_EQUAL_STRING("0201\r\n~", tester.response());
+    executeAt("MEMDUMP -f 0x%lX 20\r", mem_flash);
+    str = tester.response();
+    char *row = strstr(str, " 000102030405060708090A0B0C0D0E0F\r\n");
+    TEST_ASSERT_NOT_NULL(row);
+    TEST_ASSERT_NOT_NULL(strstr(row + 35, " 10111213\r\n~"));
+    executeAt("MEMDUMP -x 0x%lX 20\r", mem_flash);
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+#if defined(__AVR__) && defined(RAMPZ)
+    tester.execute(F("PEEK -f 0x10000\r")); // far flash
+    TEST_ASSERT_EQUAL_INT(5, tester.responseLength());
+    tester.execute(F("PEEK 0x10000\r")); // not truncated to a data address
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    tester.execute(F("MEMDUMP 0xFFF0 32\r")); // would wrap
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+    tester.execute(F("MEMDUMP -f 0x3FFF0 32\r"));
+    TEST_ASSERT_EQUAL_STRING("ERR:Bad or missing argument\r\n~", tester.response());
+#endif
+}
+
+void test_eeprom_queue()
+{
+    tester.execute(F("EEWRITE 200 0102030405060708\r")); // more than the queue holds
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EEWRITE 207 FF\r")); // coalesced if still pending
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    tester.execute(F("EEREAD 199 10\r")); // pending writes are visible
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0001020304050607FF00\r\n~"));
+    tester.execute(F("EESYNC\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("\r\n~"));
+    TEST_ASSERT_EQUAL_UINT8(0, shellEepromPending());
+    tester.execute(F("EEREAD 199 10\r"));
+    TEST_ASSERT_EQUAL_STRING(tester.response(), ("0001020304050607FF00\r\n~"));
+#if !defined(__AVR__) // drained only by shellEepromPoll()
+    uint8_t value;
+    shellEepromWrite(210, 1);
+    shellEepromWrite(211, 2);
+    shellEepromWrite(210, 3); // not merged into the older entry, 211 would be written after it
+    TEST_ASSERT_EQUAL_UINT8(3, shellEepromPending());
+    shellEepromPoll();
+    shellEepromPoll();
+    TEST_ASSERT_EQUAL_UINT8(1, shellEepromPending());
+    shellEepromRead(210, &value, 1); // the newest pending write is visible
+    TEST_ASSERT_EQUAL_UINT8(3, value);
+    shellEepromSync();
+#endif
+}
+
 /*
 void test_frame_mode()
 {
@@ -297,6 +908,23 @@ int main(int argc, char **argv)
     RUN_TEST(test_multiple_consoles);
     RUN_TEST(test_break_down_tick);
     RUN_TEST(test_external_executor);
+    RUN_TEST(test_every_command);
+    RUN_TEST(test_events);
+    RUN_TEST(test_stats_command);
+    RUN_TEST(test_endpoint_stats);
+    RUN_TEST(test_tick_profiler);
+    RUN_TEST(test_endpoint_readiness);
+    RUN_TEST(test_endpoint_framing);
+    RUN_TEST(test_ingress_queue);
+    RUN_TEST(test_eeprom_commands);
+    RUN_TEST(test_eeprom_queue);
+    RUN_TEST(test_xfer);
+    RUN_TEST(test_config_store);
+    RUN_TEST(test_pin_list);
+    RUN_TEST(test_analog_scan);
+    RUN_TEST(test_sample_capture);
+    RUN_TEST(test_watch_edges);
+    RUN_TEST(test_memory_commands);
     // RUN_TEST(test_command_errors);
     //  RUN_TEST(test_error_messages);
 
@@ -25,6 +25,10 @@ SOFTWARE.
 #include <unity.h>
 #include <TesterPrint.h>
 #include <Shell.h>
+#include <BenchStream.h>
+#include <ShellReplay.h>
+#include <TesterStream.h>
+#include <thread>
 
 ArgumentReader arg;
 TesterPrint testout;
@@ -37,8 +41,16 @@ handler(VER, "Displays firmware version.")
     return 0;
 }
 
+handler(SLOW, "Takes 20 ms.")
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    response.print(F("done"));
+    return 0;
+}
+
 DECLARE_SHELL_COMMANDS(user_commands){
     SHELL_COMMAND(VER),
+    SHELL_COMMAND_THREADSAFE(SLOW),
     SHELL_COMMAND(HELP),
     END_SHELL_COMMANDS};
 
@@ -105,6 +117,68 @@ void test_shell(void)
     // Shell.exec(F("VER"), testout);
 }
 
+void test_record_replay(void)
+{
+    BenchStream input;
+    ShellTraceBuffer trace;
+    ShellRecorder recorder(input, trace);
+    input.setInput("VER\rHELP\rXYZ\r", 1);
+    Shell.addEndpoint(recorder);
+    while (input.available())
+        Shell.tick();
+    Shell.removeEndpoint(recorder);
+    recorder.sync();
+
+    ShellReplay replay;
+    TEST_ASSERT_TRUE(replay.load(trace.data));
+    TEST_ASSERT_EQUAL_UINT32(input.written, replay.expected().size());
+    TEST_ASSERT_EQUAL_STRING("K\r\n~", replay.expected().substr(0, 4).c_str());
+    replay.run(Shell, 0);
+    TEST_ASSERT_TRUE(replay.matches());
+    TEST_ASSERT_EQUAL_INT32(-1, replay.mismatch());
+
+    trace.data[3] = 9; // unknown record type
+    TEST_ASSERT_FALSE(replay.load(trace.data));
+}
+
+#if SHELL_WORKER_THREADS > 0
+void test_worker_threads(void)
+{
+    TesterStream slow, fast;
+    Shell.addEndpoint(slow);
+    Shell.addEndpoint(fast);
+    slow.execute(F("SLOW\rVER\r")); // VER waits until SLOW completes
+    fast.execute(F("VER\r"));        // other sessions are not blocked
+    TEST_ASSERT_EQUAL_STRING("K\r\n~", fast.response());
+    for (int i = 0; i < 200; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        Shell.tick();
+    }
+    TEST_ASSERT_EQUAL_STRING("done\r\n~K\r\n~", slow.response());
+    Shell.removeEndpoint(slow);
+    Shell.removeEndpoint(fast);
+}
+
+void test_worker_removed_endpoint(void)
+{
+    ShellEndpoint node;
+    TesterStream client;
+    Shell.addEndpoint(node, client);
+    client.execute(F("SLOW\r"));
+    client.response();
+    Shell.removeEndpoint(node);
+    Shell.addEndpoint(node, client); // a new client at the same addresses while SLOW is still running
+    for (int i = 0; i < 200; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        Shell.tick();
+    }
+    TEST_ASSERT_EQUAL_STRING("", client.response());
+    Shell.removeEndpoint(node);
+}
+#endif
+
 int main(int argc, char **argv)
 {
     Shell.begin(user_commands, F("~"));
@@ -113,6 +187,11 @@ int main(int argc, char **argv)
     RUN_TEST(test_read_line);
     RUN_TEST(test_read_line_wrong_order);
     RUN_TEST(test_shell);
+    RUN_TEST(test_record_replay);
+#if SHELL_WORKER_THREADS > 0
+    RUN_TEST(test_worker_threads);
+    RUN_TEST(test_worker_removed_endpoint);
+#endif
     UNITY_END();
 
     return 0;
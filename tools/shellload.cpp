@@ -0,0 +1,365 @@
+// Load generator for shell endpoints, measures request latency percentiles, throughput and error distribution.
+// Standalone POSIX tool, build with: g++ -std=c++11 -O2 tools/shellload.cpp -o shellload
+//
+// Usage: shellload <target> [options] <command>[=weight]...
+//   target: --tcp <host>:<port> | --unix <path> | --dev <tty or pty device>
+//   -c <n>          connections, each runs one request at a time (closed loop, default 1)
+//   -r <per sec>    open loop instead, sends at this total rate regardless of responses
+//   -n <requests>   stops after this many responses (default 1000 when -t is not given)
+//   -t <seconds>    stops after this time
+//   -p <prompt>     end of response marker (default ">>")
+//   -i <command>    sent once on each connection before measuring, e.g. -i LOGIN
+//   --baud <rate>   paces sent bytes like a serial line (10 bits per byte)
+// Commands are picked randomly by weight. A response is counted as an error when a line starts with ERR:
+// (see ShellController::printError_), errors are grouped by the rest of that line.
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+static uint64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Command
+{
+    std::string line;
+    unsigned weight;
+};
+
+struct Connection
+{
+    int fd;
+    std::string rx;
+    std::string tx;              // not sent yet
+    uint64_t tx_next;            // earliest time of next byte when paced
+    std::deque<uint64_t> sent;   // start times of outstanding requests, responses come in order
+    bool ready;                  // init done
+    unsigned init_pending;
+};
+
+static void usage()
+{
+    fprintf(stderr, "usage: shellload --tcp <host>:<port> | --unix <path> | --dev <device>\n"
+                    "                 [-c conns] [-r rate] [-n requests] [-t seconds] [-p prompt] [-i init] [--baud rate]\n"
+                    "                 <command>[=weight]...\n");
+    exit(2);
+}
+
+static int connectTcp(const std::string &target)
+{
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    std::string host = target.substr(0, colon), port = target.substr(colon + 1);
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+        return -1;
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd >= 0)
+    {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+static int connectUnix(const std::string &path)
+{
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int openDevice(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+static double percentile(const std::vector<uint32_t> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+int main(int argc, char **argv)
+{
+    std::string tcp, unixpath, dev, prompt = ">>";
+    std::vector<std::string> init;
+    std::vector<Command> commands;
+    unsigned conns = 1, total_weight = 0;
+    double rate = 0, seconds = 0;
+    unsigned long limit = 0, baud = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--tcp" && more)
+            tcp = argv[++i];
+        else if (a == "--unix" && more)
+            unixpath = argv[++i];
+        else if (a == "--dev" && more)
+            dev = argv[++i];
+        else if (a == "-c" && more)
+            conns = atoi(argv[++i]);
+        else if (a == "-r" && more)
+            rate = atof(argv[++i]);
+        else if (a == "-n" && more)
+            limit = strtoul(argv[++i], 0, 10);
+        else if (a == "-t" && more)
+            seconds = atof(argv[++i]);
+        else if (a == "-p" && more)
+            prompt = argv[++i];
+        else if (a == "-i" && more)
+            init.push_back(argv[++i]);
+        else if (a == "--baud" && more)
+            baud = strtoul(argv[++i], 0, 10);
+        else if (a[0] == '-')
+            usage();
+        else
+        {
+            Command c;
+            size_t eq = a.rfind('=');
+            c.line = a.substr(0, eq);
+            c.weight = eq == std::string::npos ? 1 : atoi(a.c_str() + eq + 1);
+            total_weight += c.weight;
+            commands.push_back(c);
+        }
+    }
+    if (commands.empty() || total_weight == 0 || conns == 0 || prompt.empty() || (tcp.empty() + unixpath.empty() + dev.empty()) != 2)
+        usage();
+    if (!limit)
+        limit = seconds > 0 ? (unsigned long)-1 : 1000;
+    if (!dev.empty())
+        conns = 1; // a serial line is a single session
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Connection> cs(conns);
+    for (unsigned i = 0; i < conns; i++)
+    {
+        int fd = !tcp.empty() ? connectTcp(tcp) : !unixpath.empty() ? connectUnix(unixpath) : openDevice(dev);
+        if (fd < 0)
+        {
+            perror("connect");
+            return 1;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        cs[i].fd = fd;
+        cs[i].tx_next = 0;
+        cs[i].init_pending = init.size();
+        cs[i].ready = init.empty();
+        for (size_t k = 0; k < init.size(); k++)
+        {
+            cs[i].tx += init[k] + "\r";
+            cs[i].sent.push_back(0);
+        }
+    }
+
+    uint64_t byte_us = baud ? 10000000ULL / baud : 0;
+    std::vector<uint32_t> latencies;
+    std::map<std::string, unsigned long> errors;
+    unsigned long issued = 0, completed = 0;
+    uint64_t start = 0, next_issue = 0, deadline = 0;
+    unsigned rr = 0;
+    srand(1);
+
+    for (;;)
+    {
+        uint64_t now = now_us();
+        bool all_ready = true;
+        for (unsigned i = 0; i < conns; i++)
+            all_ready &= cs[i].ready;
+        if (all_ready && !start)
+        {
+            start = next_issue = now;
+            deadline = seconds > 0 ? start + (uint64_t)(seconds * 1e6) : 0;
+        }
+        bool stopping = start && (completed >= limit || (deadline && now >= deadline));
+        bool outstanding = false;
+        for (unsigned i = 0; i < conns; i++)
+            outstanding |= !cs[i].sent.empty();
+        if (stopping && !outstanding)
+            break;
+        if (stopping && deadline && now >= deadline + 5000000)
+            break; // gives up on lost responses
+
+        // issue new requests
+        if (start && !stopping && issued < limit)
+        {
+            if (rate > 0)
+            {
+                while (next_issue <= now && issued < limit)
+                {
+                    unsigned pick = rand() % total_weight, k = 0;
+                    while (pick >= commands[k].weight)
+                        pick -= commands[k++].weight;
+                    Connection &c = cs[rr++ % conns];
+                    c.tx += commands[k].line + "\r";
+                    c.sent.push_back(next_issue); // intended time, so queueing delay is included
+                    next_issue += (uint64_t)(1e6 / rate);
+                    issued++;
+                }
+            }
+            else
+                for (unsigned i = 0; i < conns && issued < limit; i++)
+                    if (cs[i].sent.empty())
+                    {
+                        unsigned pick = rand() % total_weight, k = 0;
+                        while (pick >= commands[k].weight)
+                            pick -= commands[k++].weight;
+                        cs[i].tx += commands[k].line + "\r";
+                        cs[i].sent.push_back(now);
+                        issued++;
+                    }
+        }
+
+        // send, paced by baud rate
+        int timeout = 100;
+        for (unsigned i = 0; i < conns; i++)
+        {
+            Connection &c = cs[i];
+            while (!c.tx.empty())
+            {
+                size_t n = c.tx.size();
+                if (byte_us)
+                {
+                    if (c.tx_next > now)
+                    {
+                        timeout = std::min<int>(timeout, (c.tx_next - now) / 1000 + 1);
+                        break;
+                    }
+                    n = 1;
+                }
+                ssize_t w = write(c.fd, c.tx.data(), n);
+                if (w <= 0)
+                    break;
+                c.tx.erase(0, w);
+                c.tx_next = std::max(c.tx_next, now) + byte_us;
+            }
+        }
+        if (rate > 0 && start && !stopping && next_issue > now)
+            timeout = std::min<int>(timeout, (next_issue - now) / 1000);
+
+        std::vector<struct pollfd> fds(conns);
+        for (unsigned i = 0; i < conns; i++)
+        {
+            fds[i].fd = cs[i].fd;
+            fds[i].events = POLLIN | (cs[i].tx.empty() || byte_us ? 0 : POLLOUT);
+            fds[i].revents = 0;
+        }
+        if (poll(fds.data(), conns, timeout) < 0 && errno != EINTR)
+        {
+            perror("poll");
+            return 1;
+        }
+        now = now_us();
+
+        // receive and parse responses, each one ends with the prompt
+        for (unsigned i = 0; i < conns; i++)
+        {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            Connection &c = cs[i];
+            char buf[4096];
+            ssize_t n = read(c.fd, buf, sizeof(buf));
+            if (n <= 0)
+            {
+                if (n < 0 && (errno == EAGAIN || errno == EINTR))
+                    continue;
+                fprintf(stderr, "connection %u closed\n", i);
+                return 1;
+            }
+            c.rx.append(buf, n);
+            size_t end;
+            while ((end = c.rx.find(prompt)) != std::string::npos)
+            {
+                std::string response = c.rx.substr(0, end);
+                c.rx.erase(0, end + prompt.size());
+                if (response.compare(0, 4, "EVT:") == 0)
+                    continue; // event frame, does not answer a request
+                if (c.sent.empty())
+                    continue; // banner or unsolicited output
+                uint64_t sent = c.sent.front();
+                c.sent.pop_front();
+                if (!c.ready)
+                {
+                    c.ready = --c.init_pending == 0;
+                    continue;
+                }
+                latencies.push_back((uint32_t)(now - sent));
+                completed++;
+                size_t err = response.find("ERR:");
+                while (err != std::string::npos && err > 0 && response[err - 1] != '\n')
+                    err = response.find("ERR:", err + 1);
+                if (err != std::string::npos)
+                {
+                    size_t eol = response.find_first_of("\r\n", err);
+                    errors[response.substr(err + 4, eol == std::string::npos ? std::string::npos : eol - err - 4)]++;
+                }
+            }
+        }
+    }
+
+    double elapsed = (now_us() - start) / 1e6;
+    std::sort(latencies.begin(), latencies.end());
+    unsigned long error_count = 0;
+    for (std::map<std::string, unsigned long>::iterator it = errors.begin(); it != errors.end(); ++it)
+        error_count += it->second;
+    printf("requests    %lu in %.2f s, %u connection(s)%s\n", completed, elapsed, conns, rate > 0 ? " open loop" : "");
+    printf("throughput  %.1f req/s\n", elapsed > 0 ? completed / elapsed : 0);
+    printf("latency us  p50 %.0f  p99 %.0f  p999 %.0f  max %.0f\n", percentile(latencies, 0.5), percentile(latencies, 0.99),
+           percentile(latencies, 0.999), latencies.empty() ? 0.0 : (double)latencies.back());
+    printf("errors      %lu\n", error_count);
+    for (std::map<std::string, unsigned long>::iterator it = errors.begin(); it != errors.end(); ++it)
+        printf("  %8lu  ERR:%s\n", it->second, it->first.c_str());
+    return 0;
+}
@@ -0,0 +1,344 @@
+// Host side of the XFER command, reads or writes EEPROM images over a shell endpoint.
+// Standalone POSIX tool, build with: g++ -std=c++11 -O2 tools/shellxfer.cpp -o shellxfer
+//
+// Usage: shellxfer <target> [options] get <addr> <len> <file>
+//        shellxfer <target> [options] put <addr> <file>
+//   target: --tcp <host>:<port> | --unix <path> | --dev <tty or pty device>
+//   -p <prompt>     end of response marker (default ">>")
+//   -i <command>    sent once before the transfer, e.g. -i LOGIN
+//   -t <ms>         reply timeout, blocks are resent after it (default 1000)
+// Protocol is described in lib/ArduinoShell/src/shellcmd/ShellCmdXFER.h
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define SOH 0x01
+#define ACK 0x06
+#define NAK 0x15
+#define CAN 0x18
+#define RETRIES 5
+
+static int fd = -1;
+static int timeout_ms = 1000;
+
+static void usage()
+{
+    fprintf(stderr, "usage: shellxfer --tcp <host>:<port> | --unix <path> | --dev <device>\n"
+                    "                 [-p prompt] [-i init] [-t ms] get <addr> <len> <file> | put <addr> <file>\n");
+    exit(2);
+}
+
+static void fail(const char *msg)
+{
+    fprintf(stderr, "shellxfer: %s\n", msg);
+    exit(1);
+}
+
+static int connectTcp(const std::string &target)
+{
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    std::string host = target.substr(0, colon), port = target.substr(colon + 1);
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+        return -1;
+    int s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (s >= 0 && connect(s, res->ai_addr, res->ai_addrlen) != 0)
+    {
+        close(s);
+        s = -1;
+    }
+    freeaddrinfo(res);
+    if (s >= 0)
+    {
+        int on = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return s;
+}
+
+static int connectUnix(const std::string &path)
+{
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path))
+        return -1;
+    int s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+static int openDevice(const std::string &path)
+{
+    int s = open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (s < 0)
+        return -1;
+    struct termios tio;
+    if (tcgetattr(s, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(s, TCSANOW, &tio);
+    }
+    return s;
+}
+
+// same as shellCrc32 on the device (zlib)
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *(data++);
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void sendAll(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len)
+    {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno != EINTR && errno != EAGAIN)
+            fail("write failed");
+        if (n > 0)
+        {
+            p += n;
+            len -= n;
+        }
+    }
+}
+
+// returns -1 on timeout
+static int readByte(int ms)
+{
+    struct pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, ms) <= 0)
+        return -1;
+    uint8_t c;
+    ssize_t n = read(fd, &c, 1);
+    if (n == 0)
+        fail("connection closed");
+    return n < 0 ? -1 : c;
+}
+
+// runs a command line, returns the response without the prompt
+static std::string command(const std::string &line, const std::string &prompt)
+{
+    std::string s = line + "\r";
+    sendAll(s.data(), s.size());
+    std::string rx;
+    while (rx.size() < prompt.size() || rx.compare(rx.size() - prompt.size(), prompt.size(), prompt) != 0)
+    {
+        int c = readByte(timeout_ms * RETRIES);
+        if (c < 0)
+            fail("no response");
+        rx += (char)c;
+    }
+    rx.resize(rx.size() - prompt.size());
+    if (rx.compare(0, 4, "ERR:") == 0)
+        fail(rx.c_str());
+    return rx;
+}
+
+static void sendBlock(const std::vector<uint8_t> &image, size_t block, unsigned block_len)
+{
+    size_t offset = block * block_len;
+    uint8_t n = std::min<size_t>(block_len, image.size() - offset);
+    std::vector<uint8_t> frame;
+    frame.push_back(SOH);
+    frame.push_back(block & 0xff);
+    frame.push_back(n);
+    frame.insert(frame.end(), image.begin() + offset, image.begin() + offset + n);
+    uint32_t crc = crc32(0, &frame[1], 2 + n);
+    for (int i = 0; i < 4; i++, crc >>= 8)
+        frame.push_back(crc & 0xff);
+    sendAll(frame.data(), frame.size());
+}
+
+static void put(const std::vector<uint8_t> &image, unsigned block_len, unsigned window)
+{
+    size_t blocks = (image.size() + block_len - 1) / block_len;
+    size_t base = 0, next = 0; // go-back-N
+    int retries = 0;
+    while (base < blocks)
+    {
+        while (next < blocks && next < base + window)
+            sendBlock(image, next++, block_len);
+        int type = readByte(timeout_ms);
+        int seq = type < 0 ? -1 : readByte(timeout_ms);
+        if (type == CAN)
+            fail("cancelled by the device");
+        if (seq < 0)
+        {
+            if (++retries > RETRIES)
+                fail("timeout");
+            next = base;
+            continue;
+        }
+        size_t ahead = (uint8_t)(seq - base);
+        if (type == ACK && ahead < next - base)
+        {
+            base += ahead + 1;
+            retries = 0;
+        }
+        else if (type == NAK && ahead == 0)
+            next = base;
+    }
+}
+
+static void get(std::vector<uint8_t> &image, unsigned block_len)
+{
+    size_t blocks = (image.size() + block_len - 1) / block_len;
+    size_t done = 0;
+    int retries = 0;
+    bool nak_sent = false;
+    while (done < blocks)
+    {
+        int c = readByte(timeout_ms);
+        if (c < 0)
+        {
+            if (++retries > RETRIES)
+            {
+                uint8_t can = CAN;
+                sendAll(&can, 1);
+                fail("timeout");
+            }
+            uint8_t nak[2] = {NAK, (uint8_t)done};
+            sendAll(nak, 2);
+            continue;
+        }
+        if (c == CAN)
+            fail("cancelled by the device");
+        if (c != SOH)
+            continue;
+        uint8_t frame[2 + 255 + 4];
+        int seq = readByte(timeout_ms), len = seq < 0 ? -1 : readByte(timeout_ms);
+        if (len <= 0)
+            continue;
+        frame[0] = seq;
+        frame[1] = len;
+        bool complete = true;
+        for (int i = 0; i < len + 4 && complete; i++)
+        {
+            int b = readByte(timeout_ms);
+            complete = b >= 0;
+            frame[2 + i] = b;
+        }
+        uint32_t crc = frame[2 + len] | frame[3 + len] << 8 | frame[4 + len] << 16 | (uint32_t)frame[5 + len] << 24;
+        size_t offset = done * block_len;
+        if (complete && crc == crc32(0, frame, 2 + len) && seq == (int)(done & 0xff) && (size_t)len == std::min<size_t>(block_len, image.size() - offset))
+        {
+            memcpy(&image[offset], &frame[2], len);
+            uint8_t ack[2] = {ACK, (uint8_t)seq};
+            sendAll(ack, 2);
+            done++;
+            retries = 0;
+            nak_sent = false;
+        }
+        else if (!nak_sent) // blocks after a bad one are dropped until the device goes back
+        {
+            uint8_t nak[2] = {NAK, (uint8_t)done};
+            sendAll(nak, 2);
+            nak_sent = true;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string prompt = ">>", init;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        if (i + 1 >= argc && (a == "--tcp" || a == "--unix" || a == "--dev" || a == "-p" || a == "-i" || a == "-t"))
+            usage();
+        if (a == "--tcp")
+            fd = connectTcp(argv[++i]);
+        else if (a == "--unix")
+            fd = connectUnix(argv[++i]);
+        else if (a == "--dev")
+            fd = openDevice(argv[++i]);
+        else if (a == "-p")
+            prompt = argv[++i];
+        else if (a == "-i")
+            init = argv[++i];
+        else if (a == "-t")
+            timeout_ms = atoi(argv[++i]);
+        else
+            args.push_back(a);
+    }
+    if (fd < 0)
+        fail("cannot connect");
+    bool is_get = args.size() == 4 && args[0] == "get";
+    if (!is_get && !(args.size() == 3 && args[0] == "put"))
+        usage();
+    if (!init.empty())
+        command(init, prompt);
+
+    std::vector<uint8_t> image;
+    std::string line = "XFER EE ";
+    if (is_get)
+    {
+        image.resize(atoi(args[2].c_str()));
+        line += "GET " + args[1] + " " + args[2];
+    }
+    else
+    {
+        FILE *f = fopen(args[2].c_str(), "rb");
+        if (!f)
+            fail("cannot open file");
+        uint8_t buf[256];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            image.insert(image.end(), buf, buf + n);
+        fclose(f);
+        line += "PUT " + args[1] + " " + std::to_string(image.size());
+    }
+    if (image.empty())
+        fail("nothing to transfer");
+    unsigned block_len = 0, window = 0;
+    if (sscanf(command(line, prompt).c_str(), "%u %u", &block_len, &window) != 2 || !block_len || !window)
+        fail("unexpected XFER response");
+    if (is_get)
+    {
+        get(image, block_len);
+        FILE *f = fopen(args[3].c_str(), "wb");
+        if (!f || fwrite(image.data(), 1, image.size(), f) != image.size())
+            fail("cannot write file");
+        fclose(f);
+    }
+    else
+        put(image, block_len, window);
+    fprintf(stderr, "%zu bytes transferred\n", image.size());
+    close(fd);
+    return 0;
+}
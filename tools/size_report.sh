@@ -0,0 +1,13 @@
+#!/bin/sh
+# Builds src/main.cpp with each footprint profile and prints flash/RAM usage per section.
+# Usage: tools/size_report.sh [env...]   (default: all profile environments in platformio.ini)
+# Output is one line per environment: <env> <.text> <.data> <.bss>, flash is .text+.data and RAM is .data+.bss
+set -e
+cd "$(dirname "$0")/.."
+ENVS=${*:-"mega_tiny mega_standard mega_full nano168_tiny"}
+printf "%-16s %8s %8s %8s\n" env text data bss
+for env in $ENVS; do
+    pio run -s -e "$env" >/dev/null
+    pio pkg exec -p toolchain-atmelavr -- avr-size ".pio/build/$env/firmware.elf" |
+        awk -v env="$env" 'NR == 2 { printf "%-16s %8s %8s %8s\n", env, $1, $2, $3 }'
+done